@@ -0,0 +1,545 @@
+#include "collisions.hpp"
+#include "constants.hpp"
+#include "integration.hpp"
+#include "particle_system.hpp"
+#include "state_output.hpp"
+#include "unit_system.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#define BENCH_UNIT_SYSTEM "G1"
+#define BENCH_DIR_NAME "gravity-bench"
+#define BENCH_RANDOM_SEED 42
+#define DEFAULT_MIN_SECONDS 0.2
+#define DEFAULT_REPETITIONS 5
+#define DEFAULT_REGRESSION_THRESHOLD 0.1
+
+struct BenchmarkResult {
+        std::string name;
+        double value;
+        std::string unit;
+        bool higherIsBetter;
+};
+
+struct BenchmarkOptions {
+        bool quick = false;
+        std::filesystem::path outputPath;
+        std::filesystem::path baselinePath;
+        double regressionThreshold = DEFAULT_REGRESSION_THRESHOLD;
+        double minSeconds = DEFAULT_MIN_SECONDS;
+        int repetitions = DEFAULT_REPETITIONS;
+};
+
+// Discards everything written to it but counts the number of bytes
+class CountingBuffer : public std::streambuf {
+    public:
+        size_t byteCount = 0;
+
+    protected:
+        int overflow(int c) override {
+            byteCount++;
+            return c;
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize count) override {
+            byteCount += static_cast<size_t>(count);
+            return count;
+        }
+};
+
+// Temporary directory for the input and output files of the benchmarks, which is
+// removed on destruction. Its random suffix keeps concurrent runs from sharing it.
+class BenchDirectory {
+    public:
+        std::filesystem::path path;
+
+        BenchDirectory() {
+            std::random_device randomDevice;
+
+            do {
+                path = std::filesystem::temp_directory_path()
+                    / std::format("{}-{:08x}", BENCH_DIR_NAME, randomDevice());
+            } while (!std::filesystem::create_directory(path));
+        }
+
+        ~BenchDirectory() {
+            // Destructors must not throw
+            std::error_code errorCode;
+            std::filesystem::remove_all(path, errorCode);
+        }
+};
+
+// Sink for benchmark results so that the compiler cannot optimize the work away
+static volatile double sink;
+
+static BenchmarkOptions parseArguments(const int argc, const char* const argv[]);
+template <typename Function>
+static double measureSecondsPerCall(const BenchmarkOptions& options, Function run);
+template <typename T>
+static std::vector<Particle<T>>
+generateParticles(const size_t particleCount,
+                  const std::shared_ptr<const UnitSystem> unitSystem);
+static void writeInputFile(const std::filesystem::path& filePath,
+                           const std::vector<Particle<double>>& particles);
+static void addResult(std::vector<BenchmarkResult>& results, const std::string& name,
+                      const double value, const std::string& unit,
+                      const bool higherIsBetter);
+template <typename T, typename F>
+static void benchmarkForces(const BenchmarkOptions& options,
+                            const std::string& precision,
+                            const std::shared_ptr<const UnitSystem> unitSystem,
+                            std::vector<BenchmarkResult>& results);
+static void benchmarkSteps(const BenchmarkOptions& options,
+                           const std::shared_ptr<const UnitSystem> unitSystem,
+                           std::vector<BenchmarkResult>& results);
+static void benchmarkCollisions(const BenchmarkOptions& options,
+                                const std::shared_ptr<const UnitSystem> unitSystem,
+                                std::vector<BenchmarkResult>& results);
+static void benchmarkParsing(const BenchmarkOptions& options,
+                             const std::shared_ptr<const UnitSystem> unitSystem,
+                             const std::filesystem::path& benchDirPath,
+                             std::vector<BenchmarkResult>& results);
+static void benchmarkWriteState(const BenchmarkOptions& options,
+                                const std::shared_ptr<const UnitSystem> unitSystem,
+                                std::vector<BenchmarkResult>& results);
+static void benchmarkSweep(const BenchmarkOptions& options,
+                           const std::shared_ptr<const UnitSystem> unitSystem,
+                           const std::filesystem::path& benchDirPath,
+                           std::vector<BenchmarkResult>& results);
+static void writeResults(std::ostream& outputStream,
+                         const std::vector<BenchmarkResult>& results);
+static std::map<std::string, double>
+loadBaseline(const std::filesystem::path& filePath);
+static bool compareResults(const std::vector<BenchmarkResult>& results,
+                           const std::map<std::string, double>& baseline,
+                           const double regressionThreshold);
+
+// Usage: gravity-bench [--quick] [--output <file>] [--compare <baseline-file>]
+//                      [--threshold <relative-change>]
+int main(const int argc, const char* const argv[]) {
+    const BenchmarkOptions options = parseArguments(argc, argv);
+    const std::shared_ptr<const UnitSystem> unitSystem
+        = std::make_shared<const UnitSystem>(BENCH_UNIT_SYSTEM);
+    const BenchDirectory benchDirectory;
+
+    std::vector<BenchmarkResult> results;
+
+    benchmarkForces<double, double>(options, "double", unitSystem, results);
+    benchmarkForces<float, float>(options, "float", unitSystem, results);
+    benchmarkForces<double, float>(options, "mixed", unitSystem, results);
+    benchmarkSteps(options, unitSystem, results);
+    benchmarkCollisions(options, unitSystem, results);
+    benchmarkParsing(options, unitSystem, benchDirectory.path, results);
+    benchmarkWriteState(options, unitSystem, results);
+    benchmarkSweep(options, unitSystem, benchDirectory.path, results);
+
+    if (options.outputPath.empty()) {
+        writeResults(std::cout, results);
+    } else {
+        std::ofstream outputFile = createOutputFile(options.outputPath);
+        writeResults(outputFile, results);
+    }
+
+    if (!options.baselinePath.empty()) {
+        const bool hasRegression = compareResults(
+            results, loadBaseline(options.baselinePath), options.regressionThreshold);
+
+        if (hasRegression) return 1;
+    }
+
+    return 0;
+}
+
+static BenchmarkOptions parseArguments(const int argc, const char* const argv[]) {
+    BenchmarkOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--quick") {
+            options.quick = true;
+            options.minSeconds = 0.05;
+            options.repetitions = 3;
+        } else if (argument == "--output" && hasValue) {
+            options.outputPath = argv[++i];
+        } else if (argument == "--compare" && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (argument == "--threshold" && hasValue) {
+            options.regressionThreshold = std::stod(argv[++i]);
+        } else {
+            throw std::invalid_argument("Invalid argument: '" + argument + "'");
+        }
+    }
+
+    return options;
+}
+
+// Returns the fastest time per call of run() out of all repetitions, each of which
+// calls it in doubling batches until at least minSeconds have passed
+template <typename Function>
+static double measureSecondsPerCall(const BenchmarkOptions& options, Function run) {
+    using namespace std::chrono;
+
+    double minSecondsPerCall = std::numeric_limits<double>::infinity();
+
+    for (int repetition = 0; repetition < options.repetitions; repetition++) {
+        unsigned long callCount = 0;
+        unsigned long batchSize = 1;
+        double elapsedSeconds = 0.0;
+
+        const steady_clock::time_point startTime = steady_clock::now();
+
+        while (elapsedSeconds < options.minSeconds) {
+            for (unsigned long i = 0; i < batchSize; i++) {
+                run();
+            }
+
+            callCount += batchSize;
+            batchSize *= 2;
+            elapsedSeconds = duration<double>(steady_clock::now() - startTime).count();
+        }
+
+        minSecondsPerCall = std::min(minSecondsPerCall,
+                                     elapsedSeconds / static_cast<double>(callCount));
+    }
+
+    return minSecondsPerCall;
+}
+
+// Randomly distributes particles of unit mass on a disk whose area grows with the
+// particle count, so that the typical separation is independent of it
+template <typename T>
+static std::vector<Particle<T>>
+generateParticles(const size_t particleCount,
+                  const std::shared_ptr<const UnitSystem> unitSystem) {
+    std::mt19937 generator(BENCH_RANDOM_SEED);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    const double diskRadius = std::sqrt(static_cast<double>(particleCount));
+    std::vector<Particle<T>> particles;
+
+    for (size_t i = 0; i < particleCount; i++) {
+        const double radius = diskRadius * std::sqrt(uniform(generator));
+        const double angle = 2.0 * Constants::pi * uniform(generator);
+
+        particles.push_back(Particle<T>(
+            1.0,
+            Vector2D<T>(static_cast<T>(radius * std::cos(angle)),
+                        static_cast<T>(radius * std::sin(angle))),
+            Vector2D<T>(static_cast<T>(uniform(generator) - 0.5),
+                        static_cast<T>(uniform(generator) - 0.5)),
+            unitSystem));
+    }
+
+    return particles;
+}
+
+static void writeInputFile(const std::filesystem::path& filePath,
+                           const std::vector<Particle<double>>& particles) {
+    std::ofstream inputFile = createOutputFile(filePath);
+
+    inputFile.precision(std::numeric_limits<double>::max_digits10);
+    inputFile << BENCH_UNIT_SYSTEM << '\n';
+
+    for (const Particle<double>& particle : particles) {
+        inputFile << particle.mass << ' ' << particle.position.x << ' '
+                  << particle.position.y << ' ' << particle.velocity.x << ' '
+                  << particle.velocity.y << '\n';
+    }
+}
+
+static void addResult(std::vector<BenchmarkResult>& results, const std::string& name,
+                      const double value, const std::string& unit,
+                      const bool higherIsBetter) {
+    std::cerr << name << ": " << value << ' ' << unit << std::endl;
+
+    results.push_back({ name, value, unit, higherIsBetter });
+}
+
+// Pair force kernel (with adaptive time step) for increasing particle counts
+template <typename T, typename F>
+static void benchmarkForces(const BenchmarkOptions& options,
+                            const std::string& precision,
+                            const std::shared_ptr<const UnitSystem> unitSystem,
+                            std::vector<BenchmarkResult>& results) {
+    const std::vector<size_t> particleCounts
+        = options.quick ? std::vector<size_t> { 3, 10, 100, 1000 }
+                        : std::vector<size_t> { 3, 10, 100, 1000, 10000 };
+
+    for (const size_t particleCount : particleCounts) {
+        const std::vector<Particle<T>> particles
+            = generateParticles<T>(particleCount, unitSystem);
+        const double interactionCount
+            = 0.5 * static_cast<double>(particleCount * (particleCount - 1));
+
+        for (const bool withPotential : { false, true }) {
+            const double secondsPerCall = measureSecondsPerCall(options, [&]() {
+                double timeStep = 0.0;
+                T potentialEnergy = 0.0;
+
+                const std::vector<Vector2D<F>> accelerations
+                    = calculateAccelerations<T, F>(
+                        particles, timeStep, true, 1.0, 0.0,
+                        withPotential ? &potentialEnergy : nullptr);
+
+                sink = accelerations[0].x + timeStep + potentialEnergy;
+            });
+
+            addResult(results,
+                      std::format("{}/{}/n={}",
+                                  withPotential ? "forcePotential" : "force",
+                                  precision, particleCount),
+                      secondsPerCall / interactionCount * 1E9, "ns/interaction", false);
+        }
+    }
+}
+
+// Cost of a single time step of each integration method (double precision)
+static void benchmarkSteps(const BenchmarkOptions& options,
+                           const std::shared_ptr<const UnitSystem> unitSystem,
+                           std::vector<BenchmarkResult>& results) {
+    for (const std::string integrationMethod : { "kdk", "dkd", "euler", "rk4" }) {
+        for (const size_t particleCount : { 3, 100 }) {
+            std::vector<Particle<double>> particles
+                = generateParticles<double>(particleCount, unitSystem);
+            double timeStep = 0.0;
+            std::vector<Vector2D<double>> accelerations
+                = calculateAccelerations<double, double>(particles, timeStep, true,
+                                                         1E-6, 0.0);
+
+            // The tiny velocity step keeps the system (almost) in its initial state
+            const double secondsPerCall = measureSecondsPerCall(options, [&]() {
+                integrate<double, double>(accelerations, particles, timeStep,
+                                          integrationMethod, true, 1E-6, 0.0, nullptr);
+            });
+
+            sink = particles[0].position.x;
+
+            addResult(results,
+                      std::format("step/{}/n={}", integrationMethod, particleCount),
+                      1.0 / secondsPerCall, "steps/s", true);
+        }
+    }
+}
+
+// Search for colliding pairs (of which there are few) with the spatial hash grid, whose
+// cost per particle should not grow with the particle count
+static void benchmarkCollisions(const BenchmarkOptions& options,
+                                const std::shared_ptr<const UnitSystem> unitSystem,
+                                std::vector<BenchmarkResult>& results) {
+    for (const size_t particleCount : { 1000, 100000 }) {
+        const std::vector<Particle<double>> particles
+            = generateParticles<double>(particleCount, unitSystem);
+
+        const double secondsPerCall = measureSecondsPerCall(options, [&]() {
+            sink = static_cast<double>(findCollisionGroups(particles, 0.01).size());
+        });
+
+        addResult(results, std::format("collisions/n={}", particleCount),
+                  secondsPerCall / static_cast<double>(particleCount) * 1E9,
+                  "ns/particle", false);
+    }
+}
+
+// Construction of a ParticleSystem from an input file
+static void benchmarkParsing(const BenchmarkOptions& options,
+                             const std::shared_ptr<const UnitSystem> unitSystem,
+                             const std::filesystem::path& benchDirPath,
+                             std::vector<BenchmarkResult>& results) {
+    for (const size_t particleCount : { 3, 1000 }) {
+        const std::filesystem::path inputFilePath
+            = benchDirPath / std::format("parse_{}.txt", particleCount);
+
+        writeInputFile(inputFilePath,
+                       generateParticles<double>(particleCount, unitSystem));
+
+        const double secondsPerCall = measureSecondsPerCall(options, [&]() {
+            const ParticleSystem<double> particleSystem(inputFilePath, unitSystem);
+        });
+
+        addResult(results, std::format("parse/n={}", particleCount),
+                  1.0 / secondsPerCall, "systems/s", true);
+    }
+}
+
+// Formatting of state lines (into a stream that discards them)
+static void benchmarkWriteState(const BenchmarkOptions& options,
+                                const std::shared_ptr<const UnitSystem> unitSystem,
+                                std::vector<BenchmarkResult>& results) {
+    for (const size_t particleCount : { 3, 1000 }) {
+        const std::vector<Particle<double>> particles
+            = generateParticles<double>(particleCount, unitSystem);
+        const double potentialEnergy = getPotentialEnergy(particles, 0.0);
+
+        CountingBuffer countingBuffer;
+        std::ostream outputStream(&countingBuffer);
+
+        const double secondsPerCall = measureSecondsPerCall(options, [&]() {
+            writeState(outputStream, 1.0, particles, 0.0, &potentialEnergy);
+        });
+
+        std::stringstream lineStream;
+        writeState(lineStream, 1.0, particles, 0.0, &potentialEnergy);
+        const double bytesPerCall = static_cast<double>(lineStream.str().size());
+
+        addResult(results, std::format("writeState/n={}", particleCount),
+                  1.0 / secondsPerCall, "states/s", true);
+        addResult(results, std::format("writeStateBytes/n={}", particleCount),
+                  bytesPerCall / secondsPerCall / 1E6, "MB/s", true);
+    }
+}
+
+// End-to-end simulation of a small grid of 3-body systems in the style of the 3-body
+// fractal (a binary with varying phase and an incoming star with varying impact
+// parameter), including parsing and writing the output files
+static void benchmarkSweep(const BenchmarkOptions& options,
+                           const std::shared_ptr<const UnitSystem> unitSystem,
+                           const std::filesystem::path& benchDirPath,
+                           std::vector<BenchmarkResult>& results) {
+    const size_t gridSize = options.quick ? 4 : 8;
+    const std::filesystem::path inputDirPath = benchDirPath / "sweep-input";
+    const std::filesystem::path outputDirPath = benchDirPath / "sweep-output";
+    const double binaryRadius = 0.5;
+    const double binarySpeed
+        = 0.5 * std::sqrt(unitSystem->gravityConstant / binaryRadius);
+
+    for (size_t i = 0; i < gridSize; i++) {
+        for (size_t j = 0; j < gridSize; j++) {
+            const double phase = Constants::pi * static_cast<double>(i)
+                / static_cast<double>(gridSize);
+            const double impact = -4.5 + 12.0 * static_cast<double>(j)
+                    / static_cast<double>(gridSize - 1);
+            const Vector2D<double> binaryPosition
+                = Vector2D<double>(std::cos(phase), std::sin(phase)) * binaryRadius;
+            const Vector2D<double> binaryVelocity
+                = Vector2D<double>(-std::sin(phase), std::cos(phase)) * binarySpeed;
+
+            const std::vector<Particle<double>> particles
+                = { Particle<double>(1.0, binaryPosition, binaryVelocity, unitSystem),
+                    Particle<double>(1.0, binaryPosition * -1.0, binaryVelocity * -1.0,
+                                     unitSystem),
+                    Particle<double>(1.0, Vector2D<double>(10.0, impact),
+                                     Vector2D<double>(-3.0, 0.0), unitSystem) };
+
+            writeInputFile(inputDirPath / std::format("sweep_{}_{}.txt", i, j),
+                           particles);
+        }
+    }
+
+    const auto inputFileEntries = getFileEntries(inputDirPath);
+    const size_t inputFileCount = inputFileEntries.size();
+
+    const double secondsPerCall = measureSecondsPerCall(options, [&]() {
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+        for (size_t i = 0; i < inputFileCount; i++) {
+            ParticleSystem<double> particleSystem(inputFileEntries[i].path(),
+                                                  unitSystem);
+
+            particleSystem.simulate(0.01, outputDirPath, true, 0.1, 20.0, 1000000, 0.5,
+                                    "rk4");
+        }
+    });
+
+    int threadCount = 1;
+#ifdef _OPENMP
+    threadCount = omp_get_max_threads();
+#endif
+
+    addResult(results, std::format("sweep/{}x{}/threads={}", gridSize, gridSize,
+                                   threadCount),
+              static_cast<double>(inputFileCount) / secondsPerCall, "systems/s", true);
+}
+
+// One benchmark per line, so that loadBaseline() does not need a full JSON parser
+static void writeResults(std::ostream& outputStream,
+                         const std::vector<BenchmarkResult>& results) {
+    outputStream.precision(std::numeric_limits<double>::max_digits10);
+    outputStream << "{\n    \"benchmarks\": [\n";
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+
+        outputStream << "        { \"name\": \"" << result.name
+                     << "\", \"value\": " << result.value << ", \"unit\": \""
+                     << result.unit << "\", \"higherIsBetter\": "
+                     << (result.higherIsBetter ? "true" : "false") << " }"
+                     << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    outputStream << "    ]\n}" << std::endl;
+}
+
+static std::map<std::string, double>
+loadBaseline(const std::filesystem::path& filePath) {
+    const std::regex resultRegex(R"re("name": "([^"]+)", "value": ([^,]+),)re");
+
+    std::ifstream baselineFile = loadTextFile(filePath);
+    std::map<std::string, double> baseline;
+    std::string line;
+
+    while (std::getline(baselineFile, line)) {
+        std::smatch match;
+
+        if (std::regex_search(line, match, resultRegex))
+            baseline[match[1].str()] = std::stod(match[2].str());
+    }
+
+    return baseline;
+}
+
+// Prints the relative change of every result that is also in the baseline and returns
+// whether any of them got worse by more than regressionThreshold
+static bool compareResults(const std::vector<BenchmarkResult>& results,
+                           const std::map<std::string, double>& baseline,
+                           const double regressionThreshold) {
+    bool hasRegression = false;
+
+    std::cerr << "\nComparison with baseline (threshold: "
+              << regressionThreshold * 100.0 << " %):" << std::endl;
+
+    for (const BenchmarkResult& result : results) {
+        const auto baselineIterator = baseline.find(result.name);
+
+        if (baselineIterator == baseline.end()) {
+            std::cerr << result.name << ": not in baseline" << std::endl;
+            continue;
+        }
+
+        const double relativeChange
+            = (result.value - baselineIterator->second) / baselineIterator->second;
+        const bool isRegression = result.higherIsBetter
+            ? relativeChange < -regressionThreshold
+            : relativeChange > regressionThreshold;
+
+        std::cerr << result.name << ": " << std::showpos << relativeChange * 100.0
+                  << std::noshowpos << " %" << (isRegression ? "  REGRESSION" : "")
+                  << std::endl;
+
+        if (isRegression) hasRegression = true;
+    }
+
+    return hasRegression;
+}
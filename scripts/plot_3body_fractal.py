@@ -11,6 +11,8 @@ IMPACT_STEPS = 301
 PHASE_STEPS = 301
 IMPACT_RANGE = (-4.5, 7.5)
 PHASE_RANGE = (0, np.pi)
+# Written before the first state after particles have been merged (see README)
+PARTICLE_IDS_PREFIX = "# particles:"
 
 
 def main() -> None:
@@ -47,13 +49,18 @@ def generate_image_array(sim_file_paths: list[Path]) -> np.ndarray:
         x = file_index % PHASE_STEPS
         y = int(file_index / PHASE_STEPS)
 
-        sim_data = np.genfromtxt(file_path, delimiter=",")
+        particle_ids, sim_data = load_sim_segments(file_path)[-1]
 
         # This indicates an incomplete simulation due to maxIterations being reached
         if sim_data[-1, 0] == -1:
             image_array[x, y] = 1
             continue
 
+        # Stars have collided and been merged, so there is no ejected star
+        if particle_ids is not None:
+            image_array[x, y] = 0.5
+            continue
+
         ejected_star_index, deflection_angle = get_ejected_star_deflection_angle(
             sim_data
         )
@@ -63,6 +70,25 @@ def generate_image_array(sim_file_paths: list[Path]) -> np.ndarray:
     return image_array
 
 
+# Splits a simulation file at its particle id lines into segments with a constant
+# number of particles. The ids of the first segment are None (all input particles).
+def load_sim_segments(file_path: Path) -> list[tuple[list[int] | None, np.ndarray]]:
+    segments = [(None, [])]
+
+    for line in file_path.read_text().splitlines():
+        if line.startswith(PARTICLE_IDS_PREFIX):
+            ids = line.removeprefix(PARTICLE_IDS_PREFIX).split(",")
+            segments.append(([int(particle_id) for particle_id in ids], []))
+        elif line:
+            segments[-1][1].append(line)
+
+    return [
+        (particle_ids, np.loadtxt(rows, delimiter=",", ndmin=2))
+        for particle_ids, rows in segments
+        if rows
+    ]
+
+
 def get_ejected_star_deflection_angle(sim_data: np.ndarray) -> tuple[int, float]:
     before_final_positions = sim_data[-2, 4:10].reshape(-1, 2).T
     final_positions = sim_data[-1, 4:10].reshape(-1, 2).T
@@ -0,0 +1,295 @@
+#include "autotuner.hpp"
+
+#include "particle_system.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#define AUTOTUNE_INTEGRATION_METHODS {"euler", "dkd", "kdk", "rk4"}
+#define AUTOTUNE_STEP_FACTORS {4.0, 2.0, 1.0, 0.5, 0.25, 0.125, 0.0625}
+// The reference uses rk4 with this fraction of the smallest probed step parameter
+#define AUTOTUNE_REFERENCE_STEP_FACTOR 0.25
+// Number of evenly spaced times at which the energy drift of a probe is checked
+#define AUTOTUNE_ENERGY_CHECKS 16
+#define AUTOTUNE_MAX_PROBE_STEPS 10000000
+
+// Measurements of a single probe integration
+class ProbeResult {
+    public:
+        unsigned long forceEvaluations = 0;
+        double simulatedTime = 0.0;
+        double maxEnergyDrift = 0.0;
+        std::vector<double> positions; // interpolated to the probe time
+        bool isComplete = true;
+};
+
+template <typename T, typename F>
+static std::optional<AutotuneSetting>
+autotune(const Config& config,
+         const std::vector<std::filesystem::directory_entry>& sampleFileEntries);
+static std::vector<AutotuneSetting> getSettings(const Config& config);
+template <typename T, typename F>
+static ProbeResult runProbe(ParticleSystem<T, F> particleSystem,
+                           const AutotuneSetting& setting, const Config& config);
+static double getTrajectoryError(const std::vector<double>& positions,
+                                 const std::vector<double>& referencePositions);
+
+std::optional<AutotuneSetting>
+autotune(const Config& config,
+         const std::vector<std::filesystem::directory_entry>& inputFileEntries) {
+    const size_t inputFileCount = inputFileEntries.size();
+
+    if (!inputFileCount || !config.autotuneSamples)
+        throw std::invalid_argument("Autotuning needs at least one sampled system");
+
+    const size_t sampleStride
+        = std::max<size_t>(1, inputFileCount / config.autotuneSamples);
+
+    std::vector<std::filesystem::directory_entry> sampleFileEntries;
+
+    for (size_t i = 0;
+         i < inputFileCount && sampleFileEntries.size() < config.autotuneSamples;
+         i += sampleStride) {
+        sampleFileEntries.push_back(inputFileEntries[i]);
+    }
+
+    if (config.precision == "double")
+        return autotune<double, double>(config, sampleFileEntries);
+    else if (config.precision == "float")
+        return autotune<float, float>(config, sampleFileEntries);
+    else if (config.precision == "mixed")
+        return autotune<double, float>(config, sampleFileEntries);
+    else
+        throw std::runtime_error("Unknown precision: " + config.precision);
+}
+
+// Implementation of autotune for state scalar type T and force scalar type F
+template <typename T, typename F>
+static std::optional<AutotuneSetting>
+autotune(const Config& config,
+         const std::vector<std::filesystem::directory_entry>& sampleFileEntries) {
+    const std::shared_ptr<const UnitSystem> sharedUnitSystem
+        = std::make_shared<const UnitSystem>(config.unitSystem);
+
+    // The last setting is the reference
+    const std::vector<AutotuneSetting> settings = getSettings(config);
+    const size_t settingCount = settings.size();
+    const size_t candidateCount = settingCount - 1;
+    const size_t sampleCount = sampleFileEntries.size();
+
+    std::vector<ParticleSystem<T, F>> sampleSystems;
+
+    for (const auto& fileEntry : sampleFileEntries) {
+        sampleSystems.emplace_back(fileEntry.path(), sharedUnitSystem);
+        sampleSystems.back().setInteraction(config.softeningLength,
+                                            config.collisionRadius);
+    }
+
+    std::cout << "Autotuning on " << sampleCount << " systems with "
+              << candidateCount << " settings\n" << std::endl;
+
+    std::vector<ProbeResult> probeResults(sampleCount * settingCount);
+
+    // Probes with small steps take much longer than those with large ones
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for (size_t i = 0; i < probeResults.size(); i++) {
+        probeResults[i] = runProbe(sampleSystems[i / settingCount],
+                                   settings[i % settingCount], config);
+    }
+
+    const bool hasTrajectoryBudget = config.autotuneMaxTrajectoryError > 0.0;
+
+    for (size_t i = 0; i < sampleCount; i++) {
+        if (hasTrajectoryBudget
+            && !probeResults[i * settingCount + candidateCount].isComplete)
+            throw std::runtime_error("Reference probe exceeded the maximum step count, "
+                                     "reduce autotuneProbeTime");
+    }
+
+    std::optional<AutotuneSetting> bestSetting;
+
+    std::cout << std::left << std::setw(8) << "Method" << std::setw(16)
+              << (config.enableAdaptiveTimeStep ? "maxVelocityStep" : "fixedTimeStep")
+              << std::setw(20) << "Force evals/time" << std::setw(20)
+              << "Max energy drift" << "Max trajectory error" << std::endl;
+
+    for (size_t i = 0; i < candidateCount; i++) {
+        AutotuneSetting setting = settings[i];
+        unsigned long forceEvaluations = 0;
+        double simulatedTime = 0.0;
+
+        for (size_t j = 0; j < sampleCount; j++) {
+            const ProbeResult& probeResult = probeResults[j * settingCount + i];
+            const ProbeResult& referenceResult
+                = probeResults[j * settingCount + candidateCount];
+
+            forceEvaluations += probeResult.forceEvaluations;
+            simulatedTime += probeResult.simulatedTime;
+            setting.maxEnergyDrift
+                = std::max(setting.maxEnergyDrift, probeResult.maxEnergyDrift);
+            setting.maxTrajectoryError = std::max(
+                setting.maxTrajectoryError,
+                getTrajectoryError(probeResult.positions, referenceResult.positions));
+            setting.isComplete = setting.isComplete && probeResult.isComplete;
+        }
+
+        setting.forceEvaluationsPerTime
+            = static_cast<double>(forceEvaluations) / simulatedTime;
+
+        const bool isWithinBudget = setting.isComplete
+            && (config.autotuneMaxEnergyDrift <= 0.0
+                || setting.maxEnergyDrift <= config.autotuneMaxEnergyDrift)
+            && (!hasTrajectoryBudget
+                || setting.maxTrajectoryError <= config.autotuneMaxTrajectoryError);
+
+        if (isWithinBudget
+            && (!bestSetting
+                || setting.forceEvaluationsPerTime
+                    < bestSetting->forceEvaluationsPerTime))
+            bestSetting = setting;
+
+        std::cout << std::setw(8) << setting.integrationMethod << std::setw(16)
+                  << (config.enableAdaptiveTimeStep ? setting.maxVelocityStep
+                                                    : setting.fixedTimeStep)
+                  << std::setw(20) << setting.forceEvaluationsPerTime << std::setw(20)
+                  << setting.maxEnergyDrift << setting.maxTrajectoryError
+                  << (isWithinBudget ? "" : " (exceeds budget)")
+                  << (setting.isComplete ? "" : " (incomplete)") << std::endl;
+    }
+
+    std::cout << std::right;
+
+    return bestSetting;
+}
+
+// Candidate settings for every integration method and step factor followed by the
+// reference setting
+static std::vector<AutotuneSetting> getSettings(const Config& config) {
+    const double stepParameter
+        = config.enableAdaptiveTimeStep ? config.maxVelocityStep : config.fixedTimeStep;
+
+    std::vector<AutotuneSetting> settings;
+    double minStepParameter = stepParameter;
+
+    for (const std::string integrationMethod : AUTOTUNE_INTEGRATION_METHODS) {
+        for (const double stepFactor : AUTOTUNE_STEP_FACTORS) {
+            AutotuneSetting setting;
+
+            setting.integrationMethod = integrationMethod;
+            setting.fixedTimeStep = config.fixedTimeStep;
+            setting.maxVelocityStep = config.maxVelocityStep;
+
+            if (config.enableAdaptiveTimeStep)
+                setting.maxVelocityStep = stepFactor * stepParameter;
+            else
+                setting.fixedTimeStep = stepFactor * stepParameter;
+
+            minStepParameter = std::min(minStepParameter, stepFactor * stepParameter);
+            settings.push_back(setting);
+        }
+    }
+
+    AutotuneSetting referenceSetting;
+
+    referenceSetting.integrationMethod = "rk4";
+    referenceSetting.fixedTimeStep = config.enableAdaptiveTimeStep
+        ? config.fixedTimeStep
+        : AUTOTUNE_REFERENCE_STEP_FACTOR * minStepParameter;
+    referenceSetting.maxVelocityStep = config.enableAdaptiveTimeStep
+        ? AUTOTUNE_REFERENCE_STEP_FACTOR * minStepParameter
+        : config.maxVelocityStep;
+    settings.push_back(referenceSetting);
+
+    return settings;
+}
+
+// Integrates a copy of the system until autotuneProbeTime
+template <typename T, typename F>
+static ProbeResult runProbe(ParticleSystem<T, F> particleSystem,
+                           const AutotuneSetting& setting, const Config& config) {
+    ProbeResult probeResult;
+
+    const double initialEnergy = particleSystem.getEnergy();
+    const unsigned long initialForceEvaluations
+        = particleSystem.getStats().forceEvaluations;
+    unsigned long stepCount = 0;
+
+    for (int i = 1; i <= AUTOTUNE_ENERGY_CHECKS && probeResult.isComplete; i++) {
+        const double checkTime = config.autotuneProbeTime * static_cast<double>(i)
+            / AUTOTUNE_ENERGY_CHECKS;
+
+        stepCount += particleSystem.step(
+            AUTOTUNE_MAX_PROBE_STEPS - stepCount, checkTime, setting.fixedTimeStep,
+            config.enableAdaptiveTimeStep, setting.maxVelocityStep,
+            setting.integrationMethod);
+
+        const double energy = particleSystem.getEnergy();
+        const double energyDrift = initialEnergy != 0.0
+            ? std::abs((energy - initialEnergy) / initialEnergy)
+            : std::abs(energy);
+
+        probeResult.maxEnergyDrift = std::max(probeResult.maxEnergyDrift, energyDrift);
+        probeResult.isComplete = stepCount < AUTOTUNE_MAX_PROBE_STEPS;
+    }
+
+    const size_t valueCount = 2 * particleSystem.getParticleCount();
+    std::vector<double> velocities(valueCount);
+
+    probeResult.positions.resize(valueCount);
+    particleSystem.copyState(probeResult.positions, velocities);
+
+    // The last step usually ends after the probe time, which would dominate the
+    // trajectory error of large steps
+    const double overshootTime
+        = particleSystem.getCurrentTime() - config.autotuneProbeTime;
+
+    for (size_t i = 0; i < valueCount; i++) {
+        probeResult.positions[i] -= velocities[i] * overshootTime;
+    }
+
+    probeResult.forceEvaluations
+        = particleSystem.getStats().forceEvaluations - initialForceEvaluations;
+    probeResult.simulatedTime = particleSystem.getCurrentTime();
+
+    return probeResult;
+}
+
+// Root mean square deviation of the positions relative to the root mean square distance
+// of the reference positions from their mean (infinite if other particles were merged)
+static double getTrajectoryError(const std::vector<double>& positions,
+                                 const std::vector<double>& referencePositions) {
+    if (positions.size() != referencePositions.size())
+        return std::numeric_limits<double>::infinity();
+
+    const size_t particleCount = positions.size() / 2;
+
+    double meanX = 0.0;
+    double meanY = 0.0;
+
+    for (size_t i = 0; i < particleCount; i++) {
+        meanX += referencePositions[2 * i] / static_cast<double>(particleCount);
+        meanY += referencePositions[2 * i + 1] / static_cast<double>(particleCount);
+    }
+
+    double errorSum = 0.0;
+    double scaleSum = 0.0;
+
+    for (size_t i = 0; i < particleCount; i++) {
+        const double errorX = positions[2 * i] - referencePositions[2 * i];
+        const double errorY = positions[2 * i + 1] - referencePositions[2 * i + 1];
+        const double distanceX = referencePositions[2 * i] - meanX;
+        const double distanceY = referencePositions[2 * i + 1] - meanY;
+
+        errorSum += errorX * errorX + errorY * errorY;
+        scaleSum += distanceX * distanceX + distanceY * distanceY;
+    }
+
+    return scaleSum > 0.0 ? std::sqrt(errorSum / scaleSum) : std::sqrt(errorSum);
+}
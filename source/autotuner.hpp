@@ -0,0 +1,32 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Integration parameters with the accuracy and cost measured for them by autotune()
+class AutotuneSetting {
+    public:
+        std::string integrationMethod;
+        double fixedTimeStep = 0.0;
+        double maxVelocityStep = 0.0;
+
+        double forceEvaluationsPerTime = 0.0;
+        double maxEnergyDrift = 0.0;
+        double maxTrajectoryError = 0.0;
+        bool isComplete = true; // false if a probe exceeded its maximum step count
+};
+
+// Runs short probe integrations (over autotuneProbeTime) of an evenly spaced sample of
+// autotuneSamples systems with every integration method and a range of time step
+// parameters around the configured one (maxVelocityStep with an adaptive time step,
+// fixedTimeStep otherwise). Returns the setting with the fewest force evaluations per
+// unit of simulated time whose maximum energy drift and trajectory error (relative to
+// a fine rk4 reference) on all probes are within autotuneMaxEnergyDrift and
+// autotuneMaxTrajectoryError (0 to ignore either), or std::nullopt if none is.
+std::optional<AutotuneSetting>
+autotune(const Config& config,
+         const std::vector<std::filesystem::directory_entry>& inputFileEntries);
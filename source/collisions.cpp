@@ -0,0 +1,199 @@
+#include "collisions.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+// Below this number of particles, checking all pairs is faster than building the grid
+#define COLLISION_GRID_MIN_PARTICLES 64
+// Cell coordinates are clamped to this magnitude, so that escaped particles don't
+// overflow them
+#define COLLISION_GRID_MAX_CELL 1e15
+
+template <typename T, typename PairFunction>
+static void forEachNeighbourPair(const std::vector<Particle<T>>& particles,
+                                 const double cellSize,
+                                 const PairFunction& pairFunction);
+static int64_t getCellCoordinate(const double coordinate, const double cellSize);
+static size_t getCellBucket(const int64_t cellX, const int64_t cellY,
+                            const size_t bucketCount);
+static size_t getGroupRoot(std::vector<size_t>& groupRoots, size_t index);
+
+template <typename T>
+std::vector<size_t> findCollisionGroups(const std::vector<Particle<T>>& particles,
+                                        const double collisionRadius) {
+    const size_t particleCount = particles.size();
+    const T collisionRadiusSquared = static_cast<T>(collisionRadius * collisionRadius);
+
+    // Union-find forest whose roots are the first particles of their groups. It is
+    // only allocated once the first colliding pair is found, as collisions are rare.
+    std::vector<size_t> groupRoots;
+
+    const auto checkPair = [&](const size_t i, const size_t j) {
+        const Vector2D<T> distance = particles[i].position - particles[j].position;
+
+        if (distance.dotProduct(distance) >= collisionRadiusSquared) return;
+
+        if (groupRoots.empty()) {
+            groupRoots.resize(particleCount);
+            std::iota(groupRoots.begin(), groupRoots.end(), 0);
+        }
+
+        const size_t rootI = getGroupRoot(groupRoots, i);
+        const size_t rootJ = getGroupRoot(groupRoots, j);
+
+        groupRoots[std::max(rootI, rootJ)] = std::min(rootI, rootJ);
+    };
+
+    if (particleCount < COLLISION_GRID_MIN_PARTICLES) {
+        for (size_t i = 0; i + 1 < particleCount; i++) {
+            for (size_t j = i + 1; j < particleCount; j++) {
+                checkPair(i, j);
+            }
+        }
+    } else {
+        forEachNeighbourPair(particles, collisionRadius, checkPair);
+    }
+
+    for (size_t i = 0; i < groupRoots.size(); i++) {
+        groupRoots[i] = getGroupRoot(groupRoots, i);
+    }
+
+    return groupRoots;
+}
+
+// Momentum is conserved as every merged particle moves with the centre of mass velocity
+// of its group
+template <typename T>
+std::vector<Particle<T>> mergeParticleGroups(const std::vector<Particle<T>>& particles,
+                                             const std::vector<size_t>& groupRoots) {
+    std::vector<size_t> mergeOrder(particles.size());
+    std::vector<Particle<T>> mergedParticles;
+
+    // Sorting by root lists the groups in the order of their first particles, each
+    // starting with that particle
+    std::iota(mergeOrder.begin(), mergeOrder.end(), 0);
+    std::stable_sort(mergeOrder.begin(), mergeOrder.end(),
+                     [&](const size_t a, const size_t b) {
+                         return groupRoots[a] < groupRoots[b];
+                     });
+
+    for (const size_t index : mergeOrder) {
+        if (groupRoots[index] == index) {
+            mergedParticles.push_back(particles[index]);
+        } else {
+            // Particles can't be assigned, as their mass is constant
+            const Particle<T> mergedParticle
+                = mergedParticles.back().merge(particles[index]);
+
+            mergedParticles.pop_back();
+            mergedParticles.push_back(mergedParticle);
+        }
+    }
+
+    return mergedParticles;
+}
+
+// Calls pairFunction(i, j) with i < j for every pair of particles in the same or in
+// adjacent cells of a uniform grid with the given cell size. The cells are hashed into
+// as many buckets as there are particles (rounded up to a power of 2), so that the grid
+// takes O(N) memory for any extent of the system. Pairs in cells which share a bucket
+// are passed as well.
+template <typename T, typename PairFunction>
+static void forEachNeighbourPair(const std::vector<Particle<T>>& particles,
+                                 const double cellSize,
+                                 const PairFunction& pairFunction) {
+    const size_t particleCount = particles.size();
+    const size_t bucketCount = std::bit_ceil(particleCount);
+
+    std::vector<int64_t> cellXs(particleCount);
+    std::vector<int64_t> cellYs(particleCount);
+    std::vector<size_t> particleBuckets(particleCount);
+    std::vector<size_t> bucketStarts(bucketCount + 1);
+    std::vector<size_t> bucketParticles(particleCount);
+
+    // Counting sort of the particles by bucket
+    for (size_t i = 0; i < particleCount; i++) {
+        cellXs[i] = getCellCoordinate(particles[i].position.x, cellSize);
+        cellYs[i] = getCellCoordinate(particles[i].position.y, cellSize);
+        particleBuckets[i] = getCellBucket(cellXs[i], cellYs[i], bucketCount);
+        bucketStarts[particleBuckets[i] + 1]++;
+    }
+
+    std::partial_sum(bucketStarts.begin(), bucketStarts.end(), bucketStarts.begin());
+
+    std::vector<size_t> bucketEnds(bucketStarts.begin(), bucketStarts.end() - 1);
+
+    for (size_t i = 0; i < particleCount; i++) {
+        bucketParticles[bucketEnds[particleBuckets[i]]++] = i;
+    }
+
+    for (size_t i = 0; i < particleCount; i++) {
+        size_t visitedBuckets[9];
+        size_t visitedBucketCount = 0;
+
+        for (int64_t offsetX = -1; offsetX <= 1; offsetX++) {
+            for (int64_t offsetY = -1; offsetY <= 1; offsetY++) {
+                const size_t bucket = getCellBucket(cellXs[i] + offsetX,
+                                                    cellYs[i] + offsetY, bucketCount);
+                size_t* const visitedBucketsEnd = visitedBuckets + visitedBucketCount;
+
+                if (std::find(visitedBuckets, visitedBucketsEnd, bucket)
+                    != visitedBucketsEnd)
+                    continue;
+
+                visitedBuckets[visitedBucketCount++] = bucket;
+
+                const size_t bucketEnd = bucketStarts[bucket + 1];
+
+                for (size_t k = bucketStarts[bucket]; k < bucketEnd; k++) {
+                    const size_t j = bucketParticles[k];
+
+                    if (j > i) pairFunction(i, j);
+                }
+            }
+        }
+    }
+}
+
+static int64_t getCellCoordinate(const double coordinate, const double cellSize) {
+    const double cell = std::floor(coordinate / cellSize);
+
+    if (std::isnan(cell)) return 0;
+
+    return static_cast<int64_t>(
+        std::clamp(cell, -COLLISION_GRID_MAX_CELL, COLLISION_GRID_MAX_CELL));
+}
+
+static size_t getCellBucket(const int64_t cellX, const int64_t cellY,
+                            const size_t bucketCount) {
+    const uint64_t hash = static_cast<uint64_t>(cellX) * 0x9E3779B97F4A7C15
+        ^ static_cast<uint64_t>(cellY) * 0xC2B2AE3D27D4EB4F;
+
+    return static_cast<size_t>(hash ^ hash >> 32) & (bucketCount - 1);
+}
+
+// Also halves the path to the root, so that later lookups are faster
+static size_t getGroupRoot(std::vector<size_t>& groupRoots, size_t index) {
+    while (groupRoots[index] != index) {
+        groupRoots[index] = groupRoots[groupRoots[index]];
+        index = groupRoots[index];
+    }
+
+    return index;
+}
+
+template std::vector<size_t>
+findCollisionGroups(const std::vector<Particle<double>>& particles,
+                    const double collisionRadius);
+template std::vector<size_t>
+findCollisionGroups(const std::vector<Particle<float>>& particles,
+                    const double collisionRadius);
+template std::vector<Particle<double>>
+mergeParticleGroups(const std::vector<Particle<double>>& particles,
+                    const std::vector<size_t>& groupRoots);
+template std::vector<Particle<float>>
+mergeParticleGroups(const std::vector<Particle<float>>& particles,
+                    const std::vector<size_t>& groupRoots);
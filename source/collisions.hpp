@@ -0,0 +1,19 @@
+#pragma once
+
+#include "particle.hpp"
+
+#include <vector>
+
+// Finds all groups of particles which are connected by pairs closer than
+// collisionRadius, using a uniform spatial hash grid for larger systems (O(N) for
+// particles which are not packed much denser than collisionRadius). Returns the index
+// of the first particle of its group for every particle, or an empty vector if no
+// particles collide.
+template <typename T>
+std::vector<size_t> findCollisionGroups(const std::vector<Particle<T>>& particles,
+                                        const double collisionRadius);
+// Merges every group (see findCollisionGroups) into a single particle (see
+// Particle::merge), which takes the place of the group's first particle
+template <typename T>
+std::vector<Particle<T>> mergeParticleGroups(const std::vector<Particle<T>>& particles,
+                                             const std::vector<size_t>& groupRoots);
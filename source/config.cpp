@@ -4,21 +4,72 @@
 #include "error_dict.hpp"
 
 #include <format>
+#include <sstream>
 
-static ErrorDict<std::string> getConfigDict(const std::filesystem::path& configPath);
+// Defaults of the parameters of optional features, which keep these features disabled
+// for config files written before they were added
+#define DEFAULT_PRECISION "double"
+#define DEFAULT_PRECISION_VALIDATION_SAMPLES 0
+// No performance report is written without a path
+#define DEFAULT_PERFORMANCE_REPORT_PATH ""
+#define DEFAULT_PROGRESS_INTERVAL 0.0
+// A single shard with all input files
+#define DEFAULT_SHARD_MODE "range"
+#define DEFAULT_SHARD_COUNT 1
+#define DEFAULT_SHARD_INDEX 0
+#define DEFAULT_SHARD_MANIFEST_DIR_PATH "../output/manifests/"
+#define DEFAULT_ENABLE_RESULT_CACHE false
+#define DEFAULT_RESULT_CACHE_DIR_PATH "../output/result-cache/"
+// The autotuner only runs with --autotune, these are the values of example-config.txt
+#define DEFAULT_AUTOTUNE_MAX_ENERGY_DRIFT 1e-6
+#define DEFAULT_AUTOTUNE_MAX_TRAJECTORY_ERROR 0.0
+#define DEFAULT_AUTOTUNE_SAMPLES 8
+#define DEFAULT_AUTOTUNE_PROBE_TIME 20.0
+#define DEFAULT_THREAD_PLACEMENT "none"
+#define DEFAULT_ENABLE_METRICS_SOCKET false
+#define DEFAULT_METRICS_SOCKET_PATH "../output/gravity-metrics.sock"
+#define DEFAULT_SOFTENING_LENGTH 0.0
+#define DEFAULT_COLLISION_RADIUS 0.0
+
+static ErrorDict<std::string> getConfigDict(std::istream& configStream);
+static std::string getParam(const std::string& paramName,
+                            const ErrorDict<std::string>& configDict,
+                            const std::string& defaultValue);
 static double parseDoubleParam(const std::string& paramName,
                                const ErrorDict<std::string>& configDict);
 static unsigned long parseUnsignedLongParam(const std::string& paramName,
                                             const ErrorDict<std::string>& configDict);
 static bool parseBoolParam(const std::string& paramName,
                            const ErrorDict<std::string>& configDict);
+static double parseDoubleParam(const std::string& paramName,
+                               const ErrorDict<std::string>& configDict,
+                               const double defaultValue);
+static unsigned long parseUnsignedLongParam(const std::string& paramName,
+                                            const ErrorDict<std::string>& configDict,
+                                            const unsigned long defaultValue);
+static bool parseBoolParam(const std::string& paramName,
+                           const ErrorDict<std::string>& configDict,
+                           const bool defaultValue);
 
 Config::Config(const UnitSystem& unitSystem, const std::filesystem::path& outputDirPath,
                const std::filesystem::path& inputFilesDirPath,
                const double fixedTimeStep, const double maxVelocityStep,
                const bool enableAdaptiveTimeStep, const double maxTime,
                const unsigned long maxIterations, const double writeStatePeriod,
-               const std::string& integrationMethod)
+               const std::string& integrationMethod, const std::string& precision,
+               const unsigned long precisionValidationSamples,
+               const std::filesystem::path& performanceReportPath,
+               const double progressInterval, const std::string& shardMode,
+               const unsigned long shardCount, const unsigned long shardIndex,
+               const std::filesystem::path& shardManifestDirPath,
+               const bool enableResultCache,
+               const std::filesystem::path& resultCacheDirPath,
+               const double autotuneMaxEnergyDrift,
+               const double autotuneMaxTrajectoryError,
+               const unsigned long autotuneSamples, const double autotuneProbeTime,
+               const std::string& threadPlacement, const bool enableMetricsSocket,
+               const std::filesystem::path& metricsSocketPath,
+               const double softeningLength, const double collisionRadius)
     : unitSystem(unitSystem)
     , outputDirPath(outputDirPath)
     , inputFilesDirPath(inputFilesDirPath)
@@ -28,11 +79,36 @@ Config::Config(const UnitSystem& unitSystem, const std::filesystem::path& output
     , maxTime(maxTime)
     , maxIterations(maxIterations)
     , writeStatePeriod(writeStatePeriod)
-    , integrationMethod(integrationMethod) {
+    , integrationMethod(integrationMethod)
+    , precision(precision)
+    , precisionValidationSamples(precisionValidationSamples)
+    , performanceReportPath(performanceReportPath)
+    , progressInterval(progressInterval)
+    , shardMode(shardMode)
+    , shardCount(shardCount)
+    , shardIndex(shardIndex)
+    , shardManifestDirPath(shardManifestDirPath)
+    , enableResultCache(enableResultCache)
+    , resultCacheDirPath(resultCacheDirPath)
+    , autotuneMaxEnergyDrift(autotuneMaxEnergyDrift)
+    , autotuneMaxTrajectoryError(autotuneMaxTrajectoryError)
+    , autotuneSamples(autotuneSamples)
+    , autotuneProbeTime(autotuneProbeTime)
+    , threadPlacement(threadPlacement)
+    , enableMetricsSocket(enableMetricsSocket)
+    , metricsSocketPath(metricsSocketPath)
+    , softeningLength(softeningLength)
+    , collisionRadius(collisionRadius) {
 }
 
 Config Config::load(const std::filesystem::path& configPath) {
-    const ErrorDict<std::string> configDict = getConfigDict(configPath);
+    std::ifstream configFile = loadTextFile(configPath);
+
+    return parse(configFile);
+}
+
+Config Config::parse(std::istream& configStream) {
+    const ErrorDict<std::string> configDict = getConfigDict(configStream);
 
     const UnitSystem unitSystem(configDict.at("unitSystem"));
     const std::filesystem::path outputDirPath = configDict.at("outputDir");
@@ -46,19 +122,103 @@ Config Config::load(const std::filesystem::path& configPath) {
         = parseUnsignedLongParam("maxIterations", configDict);
     const double writeStatePeriod = parseDoubleParam("writeStatePeriod", configDict);
     const std::string integrationMethod = configDict.at("integrationMethod");
+    const std::string precision
+        = getParam("precision", configDict, DEFAULT_PRECISION);
+    const unsigned long precisionValidationSamples
+        = parseUnsignedLongParam("precisionValidationSamples", configDict,
+                                 DEFAULT_PRECISION_VALIDATION_SAMPLES);
+    const std::filesystem::path performanceReportPath
+        = getParam("performanceReportPath", configDict,
+                   DEFAULT_PERFORMANCE_REPORT_PATH);
+    const double progressInterval
+        = parseDoubleParam("progressInterval", configDict, DEFAULT_PROGRESS_INTERVAL);
+    const std::string shardMode
+        = getParam("shardMode", configDict, DEFAULT_SHARD_MODE);
+    const unsigned long shardCount
+        = parseUnsignedLongParam("shardCount", configDict, DEFAULT_SHARD_COUNT);
+    const unsigned long shardIndex
+        = parseUnsignedLongParam("shardIndex", configDict, DEFAULT_SHARD_INDEX);
+    const std::filesystem::path shardManifestDirPath
+        = getParam("shardManifestDir", configDict, DEFAULT_SHARD_MANIFEST_DIR_PATH);
+    const bool enableResultCache
+        = parseBoolParam("enableResultCache", configDict, DEFAULT_ENABLE_RESULT_CACHE);
+    const std::filesystem::path resultCacheDirPath
+        = getParam("resultCacheDir", configDict, DEFAULT_RESULT_CACHE_DIR_PATH);
+    const double autotuneMaxEnergyDrift = parseDoubleParam(
+        "autotuneMaxEnergyDrift", configDict, DEFAULT_AUTOTUNE_MAX_ENERGY_DRIFT);
+    const double autotuneMaxTrajectoryError
+        = parseDoubleParam("autotuneMaxTrajectoryError", configDict,
+                           DEFAULT_AUTOTUNE_MAX_TRAJECTORY_ERROR);
+    const unsigned long autotuneSamples = parseUnsignedLongParam(
+        "autotuneSamples", configDict, DEFAULT_AUTOTUNE_SAMPLES);
+    const double autotuneProbeTime = parseDoubleParam(
+        "autotuneProbeTime", configDict, DEFAULT_AUTOTUNE_PROBE_TIME);
+    const std::string threadPlacement
+        = getParam("threadPlacement", configDict, DEFAULT_THREAD_PLACEMENT);
+    const bool enableMetricsSocket = parseBoolParam(
+        "enableMetricsSocket", configDict, DEFAULT_ENABLE_METRICS_SOCKET);
+    const std::filesystem::path metricsSocketPath
+        = getParam("metricsSocket", configDict, DEFAULT_METRICS_SOCKET_PATH);
+    const double softeningLength
+        = parseDoubleParam("softeningLength", configDict, DEFAULT_SOFTENING_LENGTH);
+    const double collisionRadius
+        = parseDoubleParam("collisionRadius", configDict, DEFAULT_COLLISION_RADIUS);
 
     return Config(unitSystem, outputDirPath, inputFilesDirPath, fixedTimeStep,
                   maxVelocityStep, enableAdaptiveTimeStep, maxTime, maxIterations,
-                  writeStatePeriod, integrationMethod);
+                  writeStatePeriod, integrationMethod, precision,
+                  precisionValidationSamples, performanceReportPath,
+                  progressInterval, shardMode, shardCount, shardIndex,
+                  shardManifestDirPath, enableResultCache, resultCacheDirPath,
+                  autotuneMaxEnergyDrift, autotuneMaxTrajectoryError, autotuneSamples,
+                  autotuneProbeTime, threadPlacement, enableMetricsSocket,
+                  metricsSocketPath, softeningLength, collisionRadius);
 }
 
-static ErrorDict<std::string> getConfigDict(const std::filesystem::path& configPath) {
+void Config::writeUpdated(const std::filesystem::path& configPath,
+                          const std::filesystem::path& outputPath,
+                          const std::map<std::string, std::string>& paramValues) {
+    std::vector<std::string> lines;
+    std::string line;
+
+    // Read everything first, as outputPath may be configPath
+    {
+        std::ifstream configFile = loadTextFile(configPath);
+
+        while (getline(configFile, line)) {
+            lines.push_back(line);
+        }
+    }
+
+    std::ofstream outputFile = createOutputFile(outputPath);
+
+    for (std::string& configLine : lines) {
+        std::stringstream lineStream(configLine);
+        std::string parameterName;
+
+        lineStream >> parameterName;
+
+        const auto paramIterator = paramValues.find(parameterName);
+
+        if (configLine.substr(0, 2) != "//" && paramIterator != paramValues.end()) {
+            const size_t valueStart = configLine.find_first_not_of(
+                " \t", configLine.find(parameterName) + parameterName.size());
+
+            configLine = valueStart != std::string::npos
+                ? configLine.substr(0, valueStart) + paramIterator->second
+                : parameterName + " " + paramIterator->second;
+        }
+
+        outputFile << configLine << '\n';
+    }
+}
+
+static ErrorDict<std::string> getConfigDict(std::istream& configStream) {
     ErrorDict<std::string> configDict("configDict");
 
-    std::ifstream configFile = loadTextFile(configPath);
     std::string line;
 
-    while (getline(configFile, line)) {
+    while (getline(configStream, line)) {
         if (line.substr(0, 2) == "//" || line == "") continue;
 
         std::stringstream lineStream(line);
@@ -112,3 +272,32 @@ static bool parseBoolParam(const std::string& paramName,
             format("Config parameter: '{} = {}' could not be converted to bool",
                    paramName, paramValue));
 }
+
+// The parameter functions with a default value return it if the parameter is missing
+static std::string getParam(const std::string& paramName,
+                            const ErrorDict<std::string>& configDict,
+                            const std::string& defaultValue) {
+    return configDict.contains(paramName) ? configDict.at(paramName) : defaultValue;
+}
+
+static double parseDoubleParam(const std::string& paramName,
+                               const ErrorDict<std::string>& configDict,
+                               const double defaultValue) {
+    return configDict.contains(paramName) ? parseDoubleParam(paramName, configDict)
+                                          : defaultValue;
+}
+
+static unsigned long parseUnsignedLongParam(const std::string& paramName,
+                                            const ErrorDict<std::string>& configDict,
+                                            const unsigned long defaultValue) {
+    return configDict.contains(paramName)
+        ? parseUnsignedLongParam(paramName, configDict)
+        : defaultValue;
+}
+
+static bool parseBoolParam(const std::string& paramName,
+                           const ErrorDict<std::string>& configDict,
+                           const bool defaultValue) {
+    return configDict.contains(paramName) ? parseBoolParam(paramName, configDict)
+                                          : defaultValue;
+}
@@ -3,6 +3,8 @@
 #include "unit_system.hpp"
 
 #include <filesystem>
+#include <istream>
+#include <map>
 #include <string>
 
 class Config {
@@ -17,13 +19,53 @@ class Config {
         const unsigned long maxIterations;
         const double writeStatePeriod;
         const std::string integrationMethod;
+        const std::string precision;
+        const unsigned long precisionValidationSamples;
+        const std::filesystem::path performanceReportPath;
+        const double progressInterval;
+        const std::string shardMode;
+        const unsigned long shardCount;
+        const unsigned long shardIndex;
+        const std::filesystem::path shardManifestDirPath;
+        const bool enableResultCache;
+        const std::filesystem::path resultCacheDirPath;
+        const double autotuneMaxEnergyDrift;
+        const double autotuneMaxTrajectoryError;
+        const unsigned long autotuneSamples;
+        const double autotuneProbeTime;
+        const std::string threadPlacement;
+        const bool enableMetricsSocket;
+        const std::filesystem::path metricsSocketPath;
+        const double softeningLength;
+        const double collisionRadius;
 
         static Config load(const std::filesystem::path& configPath);
+        // Parses a config in the format of the config file (see example-config.txt)
+        static Config parse(std::istream& configStream);
+        // Copies the config file at configPath to outputPath with the values of the
+        // given parameters replaced, keeping all comments and formatting
+        static void writeUpdated(const std::filesystem::path& configPath,
+                                 const std::filesystem::path& outputPath,
+                                 const std::map<std::string, std::string>& paramValues);
 
     private:
         Config(const UnitSystem& unitSystem, const std::filesystem::path& outputDir,
                const std::filesystem::path& inputFilesDir, const double fixedTimeStep,
                const double maxVelocityStep, const bool enableAdaptiveTimeStep,
                const double maxTime, const unsigned long maxIterations,
-               const double writeStatePeriod, const std::string& integrationMethod);
+               const double writeStatePeriod, const std::string& integrationMethod,
+               const std::string& precision,
+               const unsigned long precisionValidationSamples,
+               const std::filesystem::path& performanceReportPath,
+               const double progressInterval, const std::string& shardMode,
+               const unsigned long shardCount, const unsigned long shardIndex,
+               const std::filesystem::path& shardManifestDirPath,
+               const bool enableResultCache,
+               const std::filesystem::path& resultCacheDirPath,
+               const double autotuneMaxEnergyDrift,
+               const double autotuneMaxTrajectoryError,
+               const unsigned long autotuneSamples, const double autotuneProbeTime,
+               const std::string& threadPlacement, const bool enableMetricsSocket,
+               const std::filesystem::path& metricsSocketPath,
+               const double softeningLength, const double collisionRadius);
 };
@@ -34,6 +34,10 @@ template <typename T> const T& ErrorDict<T>::at(const std::string& key) const {
     }
 }
 
+template <typename T> bool ErrorDict<T>::contains(const std::string& key) const {
+    return map.contains(key);
+}
+
 template <typename T> T& ErrorDict<T>::operator[](const std::string& key) {
     return map[key];
 }
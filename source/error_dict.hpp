@@ -11,6 +11,7 @@ template <typename T> class ErrorDict {
 
         T& at(const std::string& key);
         const T& at(const std::string& key) const;
+        bool contains(const std::string& key) const;
 
         T& operator[](const std::string& key);
 
@@ -0,0 +1,61 @@
+/* C interface of the gravity library (libgravity), e.g. for use via Python's ctypes.
+ *
+ * Functions returning int return 0 on success and -1 on failure, functions returning
+ * pointers return NULL on failure. gravity_last_error() then describes the last failure
+ * on the calling thread. Positions and velocities are passed as interleaved (x, y)
+ * pairs of doubles in the unit system of the config. Handles must not be NULL unless
+ * stated otherwise. */
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct gravity_config gravity_config;
+typedef struct gravity_system gravity_system;
+
+const char* gravity_last_error(void);
+
+gravity_config* gravity_config_load(const char* config_path);
+/* Parses a config in the format of the config file (see example-config.txt) */
+gravity_config* gravity_config_parse(const char* config_text);
+void gravity_config_free(gravity_config* config);
+
+/* Creates a system of particle_count (at least 1) particles which uses the unit
+ * system, precision and integration parameters of config (the config may be freed
+ * afterwards) */
+gravity_system* gravity_system_create(const gravity_config* config, const char* name,
+                                      size_t particle_count, const double* masses,
+                                      const double* positions,
+                                      const double* velocities);
+/* Creates a system from an input file (see README) with at least 1 particle */
+gravity_system* gravity_system_load(const gravity_config* config,
+                                    const char* input_file_path);
+void gravity_system_free(gravity_system* system);
+
+/* Advances the system by up to max_steps integration steps (0 for no limit) or until
+ * its time exceeds max_time without writing anything. steps_taken may be NULL. */
+int gravity_system_step(gravity_system* system, unsigned long max_steps,
+                        double max_time, unsigned long* steps_taken);
+/* Simulates the system from its current state like the executable, writing the output
+ * file into output_dir_path */
+int gravity_system_simulate(gravity_system* system, const char* output_dir_path);
+
+/* Decreases when particles collide and are merged (see collisionRadius) */
+size_t gravity_system_particle_count(const gravity_system* system);
+double gravity_system_time(const gravity_system* system);
+double gravity_system_time_step(const gravity_system* system);
+double gravity_system_energy(const gravity_system* system);
+/* See ParticleSystem::getOutcome */
+int gravity_system_outcome(const gravity_system* system);
+/* Writes the state into caller-provided buffers of 2 * particle_count doubles each
+ * (either of them may be NULL) */
+int gravity_system_get_state(const gravity_system* system, double* positions,
+                             double* velocities);
+
+#ifdef __cplusplus
+}
+#endif
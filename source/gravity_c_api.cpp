@@ -0,0 +1,207 @@
+#include "gravity.h"
+
+#include "config.hpp"
+#include "particle_system.hpp"
+
+#include <exception>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <string>
+#include <variant>
+
+#define C_API_SYSTEM_NAME "system"
+
+struct gravity_config {
+        const Config config;
+};
+
+struct gravity_system {
+        const Config config;
+        std::variant<ParticleSystem<double>, ParticleSystem<float>,
+                     ParticleSystem<double, float>>
+            particleSystem;
+};
+
+static thread_local std::string lastError;
+
+template <typename R, typename Function>
+static R callSafely(const R failureValue, const Function& function);
+template <typename... Args>
+static gravity_system* createSystem(const Config& config, const Args&... args);
+
+const char* gravity_last_error(void) {
+    return lastError.c_str();
+}
+
+gravity_config* gravity_config_load(const char* config_path) {
+    return callSafely<gravity_config*>(nullptr, [&]() {
+        return new gravity_config{Config::load(config_path)};
+    });
+}
+
+gravity_config* gravity_config_parse(const char* config_text) {
+    return callSafely<gravity_config*>(nullptr, [&]() {
+        std::istringstream configStream(config_text);
+
+        return new gravity_config{Config::parse(configStream)};
+    });
+}
+
+void gravity_config_free(gravity_config* config) {
+    delete config;
+}
+
+gravity_system* gravity_system_create(const gravity_config* config, const char* name,
+                                      size_t particle_count, const double* masses,
+                                      const double* positions,
+                                      const double* velocities) {
+    return callSafely<gravity_system*>(nullptr, [&]() {
+        return createSystem(config->config,
+                            std::string(name ? name : C_API_SYSTEM_NAME),
+                            std::span<const double>(masses, particle_count),
+                            std::span<const double>(positions, 2 * particle_count),
+                            std::span<const double>(velocities, 2 * particle_count));
+    });
+}
+
+gravity_system* gravity_system_load(const gravity_config* config,
+                                    const char* input_file_path) {
+    return callSafely<gravity_system*>(nullptr, [&]() {
+        return createSystem(config->config, std::filesystem::path(input_file_path));
+    });
+}
+
+void gravity_system_free(gravity_system* system) {
+    delete system;
+}
+
+int gravity_system_step(gravity_system* system, unsigned long max_steps,
+                        double max_time, unsigned long* steps_taken) {
+    return callSafely(-1, [&]() {
+        const Config& config = system->config;
+
+        const unsigned long stepCount = std::visit(
+            [&](auto& particleSystem) {
+                return particleSystem.step(max_steps, max_time, config.fixedTimeStep,
+                                           config.enableAdaptiveTimeStep,
+                                           config.maxVelocityStep,
+                                           config.integrationMethod);
+            },
+            system->particleSystem);
+
+        if (steps_taken) *steps_taken = stepCount;
+
+        return 0;
+    });
+}
+
+int gravity_system_simulate(gravity_system* system, const char* output_dir_path) {
+    return callSafely(-1, [&]() {
+        const Config& config = system->config;
+
+        std::visit(
+            [&](auto& particleSystem) {
+                particleSystem.simulate(
+                    config.fixedTimeStep, output_dir_path,
+                    config.enableAdaptiveTimeStep, config.maxVelocityStep,
+                    config.maxTime, config.maxIterations, config.writeStatePeriod,
+                    config.integrationMethod);
+            },
+            system->particleSystem);
+
+        return 0;
+    });
+}
+
+size_t gravity_system_particle_count(const gravity_system* system) {
+    return std::visit(
+        [](const auto& particleSystem) { return particleSystem.getParticleCount(); },
+        system->particleSystem);
+}
+
+double gravity_system_time(const gravity_system* system) {
+    return std::visit(
+        [](const auto& particleSystem) { return particleSystem.getCurrentTime(); },
+        system->particleSystem);
+}
+
+double gravity_system_time_step(const gravity_system* system) {
+    return std::visit(
+        [](const auto& particleSystem) { return particleSystem.getTimeStep(); },
+        system->particleSystem);
+}
+
+double gravity_system_energy(const gravity_system* system) {
+    return std::visit(
+        [](const auto& particleSystem) { return particleSystem.getEnergy(); },
+        system->particleSystem);
+}
+
+int gravity_system_outcome(const gravity_system* system) {
+    return std::visit(
+        [](const auto& particleSystem) { return particleSystem.getOutcome(); },
+        system->particleSystem);
+}
+
+int gravity_system_get_state(const gravity_system* system, double* positions,
+                             double* velocities) {
+    return callSafely(-1, [&]() {
+        std::visit(
+            [&](const auto& particleSystem) {
+                const size_t valueCount = 2 * particleSystem.getParticleCount();
+
+                particleSystem.copyState(
+                    std::span<double>(positions, positions ? valueCount : 0),
+                    std::span<double>(velocities, velocities ? valueCount : 0));
+            },
+            system->particleSystem);
+
+        return 0;
+    });
+}
+
+// Calls function and converts any exception into failureValue (exceptions must not
+// cross the C interface), keeping its message for gravity_last_error()
+template <typename R, typename Function>
+static R callSafely(const R failureValue, const Function& function) {
+    try {
+        return function();
+    } catch (const std::exception& exception) {
+        lastError = exception.what();
+    } catch (...) {
+        lastError = "Unknown error";
+    }
+
+    return failureValue;
+}
+
+// Creates a system with the precision, softening length and collision radius of config
+// from the ParticleSystem constructor arguments (without the unit system)
+template <typename... Args>
+static gravity_system* createSystem(const Config& config, const Args&... args) {
+    const std::shared_ptr<const UnitSystem> sharedUnitSystem
+        = std::make_shared<const UnitSystem>(config.unitSystem);
+    gravity_system* system;
+
+    if (config.precision == "double")
+        system = new gravity_system{
+            config, ParticleSystem<double>(args..., sharedUnitSystem)};
+    else if (config.precision == "float")
+        system = new gravity_system{
+            config, ParticleSystem<float>(args..., sharedUnitSystem)};
+    else if (config.precision == "mixed")
+        system = new gravity_system{
+            config, ParticleSystem<double, float>(args..., sharedUnitSystem)};
+    else
+        throw std::runtime_error("Unknown precision: " + config.precision);
+
+    std::visit(
+        [&](auto& particleSystem) {
+            particleSystem.setInteraction(config.softeningLength,
+                                          config.collisionRadius);
+        },
+        system->particleSystem);
+
+    return system;
+}
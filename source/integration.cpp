@@ -0,0 +1,246 @@
+#include "integration.hpp"
+
+#include "performance_report.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+// Only every n-th force evaluation of a thread is timed
+#define FORCE_TIMING_SAMPLE_PERIOD 64
+
+// Calculates the accelerations of all particles and, if potentialEnergy is not nullptr,
+// the total potential energy of the system in the same pass
+template <typename T, typename F>
+std::vector<Vector2D<F>>
+calculateAccelerations(const std::vector<Particle<T>>& particles, double& timeStep,
+                       const bool enableAdaptiveTimeStep, const double maxVelocityStep,
+                       const double softeningLength, T* potentialEnergy) {
+    ForceCounters& forceCounters = threadForceCounters;
+    const bool isTimed = forceCounters.evaluations % FORCE_TIMING_SAMPLE_PERIOD == 0;
+    const std::chrono::steady_clock::time_point startTime
+        = isTimed ? std::chrono::steady_clock::now()
+                  : std::chrono::steady_clock::time_point();
+
+    const size_t particleCount = particles.size();
+    const F softeningSquared = static_cast<F>(softeningLength * softeningLength);
+    std::vector<Vector2D<F>> particleAccelerations(particleCount);
+    F maxAcceleration = 0.0;
+    T totalPotentialEnergy = 0.0;
+
+    for (size_t i = 0; i + 1 < particleCount; i++) {
+        for (size_t j = i + 1; j < particleCount; j++) {
+            Vector2D<F> factor;
+
+            if (potentialEnergy) {
+                F potentialFactor;
+                factor = particles[i].template getGravityAccelerationFactor<F>(
+                    particles[j], softeningSquared, potentialFactor);
+                totalPotentialEnergy += static_cast<T>(potentialFactor)
+                    * particles[i].mass * particles[j].mass;
+            } else {
+                factor = particles[i].template getGravityAccelerationFactor<F>(
+                    particles[j], softeningSquared);
+            }
+
+            particleAccelerations[i] = particleAccelerations[i]
+                + factor * static_cast<F>(particles[j].mass);
+            particleAccelerations[j] = particleAccelerations[j]
+                - factor * static_cast<F>(particles[i].mass);
+
+            if (enableAdaptiveTimeStep) {
+                if (particleAccelerations[i].abs() > maxAcceleration)
+                    maxAcceleration = particleAccelerations[i].abs();
+                if (particleAccelerations[j].abs() > maxAcceleration)
+                    maxAcceleration = particleAccelerations[j].abs();
+            }
+        }
+    }
+
+    // Without any forces (i.e. for a single particle), the time step is kept
+    if (enableAdaptiveTimeStep && maxAcceleration > 0.0)
+        timeStep = maxVelocityStep / static_cast<double>(maxAcceleration);
+    if (potentialEnergy) *potentialEnergy = totalPotentialEnergy;
+
+    forceCounters.evaluations++;
+    forceCounters.pairInteractions += particleCount * (particleCount - 1) / 2;
+
+    if (isTimed) {
+        forceCounters.sampledEvaluations++;
+        forceCounters.sampledSeconds += getSecondsSince(startTime);
+    }
+
+    return particleAccelerations;
+}
+
+template <typename T>
+T getPotentialEnergy(const std::vector<Particle<T>>& particles,
+                     const double softeningLength) {
+    const size_t particleCount = particles.size();
+    const T softeningSquared = static_cast<T>(softeningLength * softeningLength);
+    T potentialEnergy = 0.0;
+
+    for (size_t i = 0; i + 1 < particleCount; i++) {
+        for (size_t j = i + 1; j < particleCount; j++) {
+            potentialEnergy
+                += particles[i].getPotentialEnergy(particles[j], softeningSquared);
+        }
+    }
+
+    return potentialEnergy;
+}
+
+template <typename T> T getKineticEnergy(const std::vector<Particle<T>>& particles) {
+    T kineticEnergy = 0.0;
+
+    for (const Particle<T>& particle : particles) {
+        kineticEnergy += particle.getKineticEnergy();
+    }
+
+    return kineticEnergy;
+}
+
+// Advances the particles by one time step. On entry, particleAccelerations must hold
+// the accelerations at the current positions (kdk, rk4) and on exit it holds those at
+// the new positions. Returns true if potentialEnergy (if not nullptr) was set to the
+// potential energy at the new positions, which is only possible for methods whose last
+// force pass is evaluated there.
+template <typename T, typename F>
+bool integrate(std::vector<Vector2D<F>>& particleAccelerations,
+               std::vector<Particle<T>>& particles, double& timeStep,
+               const std::string& integrationMethod, const bool enableAdaptiveTimeStep,
+               const double maxVelocityStep, const double softeningLength,
+               T* potentialEnergy) {
+    if (integrationMethod == "kdk") {
+        for (size_t i = 0; i < particles.size(); i++) {
+            particles[i].updateVelocity(particleAccelerations[i], 0.5 * timeStep);
+            particles[i].updatePosition(particles[i].velocity, timeStep);
+        }
+
+        particleAccelerations
+            = calculateAccelerations<T, F>(particles, timeStep, enableAdaptiveTimeStep,
+                                           maxVelocityStep, softeningLength,
+                                           potentialEnergy);
+
+        for (size_t i = 0; i < particles.size(); i++) {
+            particles[i].updateVelocity(particleAccelerations[i], 0.5 * timeStep);
+        }
+
+        return potentialEnergy != nullptr;
+    } else if (integrationMethod == "dkd") {
+        for (Particle<T>& particle : particles) {
+            particle.updatePosition(particle.velocity, 0.5 * timeStep);
+        }
+
+        particleAccelerations = calculateAccelerations<T, F>(
+            particles, timeStep, enableAdaptiveTimeStep, maxVelocityStep,
+            softeningLength);
+
+        for (size_t i = 0; i < particles.size(); i++) {
+            particles[i].updateVelocity(particleAccelerations[i], timeStep);
+            particles[i].updatePosition(particles[i].velocity, 0.5 * timeStep);
+        }
+
+        return false;
+    } else if (integrationMethod == "euler") {
+        particleAccelerations = calculateAccelerations<T, F>(
+            particles, timeStep, enableAdaptiveTimeStep, maxVelocityStep,
+            softeningLength);
+
+        for (size_t i = 0; i < particles.size(); i++) {
+            particles[i].updatePosition(particles[i].velocity, timeStep);
+            particles[i].updateVelocity(particleAccelerations[i], timeStep);
+        }
+
+        return false;
+    } else if (integrationMethod == "rk4") {
+        // k1 is evaluated at the current positions, i.e. it is the result of the final
+        // force pass of the previous step
+        const std::vector<Particle<T>> k1Particles = particles;
+        const std::vector<Vector2D<F>>& k1Accelerations = particleAccelerations;
+
+        std::vector<Particle<T>> k2Particles = particles;
+        for (size_t i = 0; i < k2Particles.size(); i++) {
+            k2Particles[i].updatePosition(k1Particles[i].velocity, 0.5 * timeStep);
+            k2Particles[i].updateVelocity(k1Accelerations[i], 0.5 * timeStep);
+        }
+        const std::vector<Vector2D<F>> k2Accelerations = calculateAccelerations<T, F>(
+            k2Particles, timeStep, false, maxVelocityStep, softeningLength);
+
+        std::vector<Particle<T>> k3Particles = particles;
+        for (size_t i = 0; i < k3Particles.size(); i++) {
+            k3Particles[i].updatePosition(k2Particles[i].velocity, 0.5 * timeStep);
+            k3Particles[i].updateVelocity(k2Accelerations[i], 0.5 * timeStep);
+        }
+        const std::vector<Vector2D<F>> k3Accelerations = calculateAccelerations<T, F>(
+            k3Particles, timeStep, false, maxVelocityStep, softeningLength);
+
+        std::vector<Particle<T>> k4Particles = particles;
+        for (size_t i = 0; i < k4Particles.size(); i++) {
+            k4Particles[i].updatePosition(k3Particles[i].velocity, timeStep);
+            k4Particles[i].updateVelocity(k3Accelerations[i], timeStep);
+        }
+        const std::vector<Vector2D<F>> k4Accelerations = calculateAccelerations<T, F>(
+            k4Particles, timeStep, false, maxVelocityStep, softeningLength);
+
+        for (size_t i = 0; i < particles.size(); i++) {
+            particles[i].updatePosition(
+                (k1Particles[i].velocity + 2.0 * k2Particles[i].velocity
+                 + 2.0 * k3Particles[i].velocity + k4Particles[i].velocity)
+                    / 6.0,
+                timeStep);
+
+            particles[i].updateVelocity((k1Accelerations[i] + 2.0 * k2Accelerations[i]
+                                         + 2.0 * k3Accelerations[i]
+                                         + k4Accelerations[i])
+                                            / 6.0,
+                                        timeStep);
+        }
+
+        // Also serves as k1 of the next step
+        particleAccelerations
+            = calculateAccelerations<T, F>(particles, timeStep, enableAdaptiveTimeStep,
+                                           maxVelocityStep, softeningLength,
+                                           potentialEnergy);
+
+        return potentialEnergy != nullptr;
+    } else {
+        throw std::runtime_error("Unknown integration method: " + integrationMethod);
+    }
+}
+
+template std::vector<Vector2D<double>> calculateAccelerations<double, double>(
+    const std::vector<Particle<double>>& particles, double& timeStep,
+    const bool enableAdaptiveTimeStep, const double maxVelocityStep,
+    const double softeningLength, double* potentialEnergy);
+template std::vector<Vector2D<float>> calculateAccelerations<float, float>(
+    const std::vector<Particle<float>>& particles, double& timeStep,
+    const bool enableAdaptiveTimeStep, const double maxVelocityStep,
+    const double softeningLength, float* potentialEnergy);
+template std::vector<Vector2D<float>> calculateAccelerations<double, float>(
+    const std::vector<Particle<double>>& particles, double& timeStep,
+    const bool enableAdaptiveTimeStep, const double maxVelocityStep,
+    const double softeningLength, double* potentialEnergy);
+template bool integrate<double, double>(
+    std::vector<Vector2D<double>>& particleAccelerations,
+    std::vector<Particle<double>>& particles, double& timeStep,
+    const std::string& integrationMethod, const bool enableAdaptiveTimeStep,
+    const double maxVelocityStep, const double softeningLength,
+    double* potentialEnergy);
+template bool integrate<float, float>(
+    std::vector<Vector2D<float>>& particleAccelerations,
+    std::vector<Particle<float>>& particles, double& timeStep,
+    const std::string& integrationMethod, const bool enableAdaptiveTimeStep,
+    const double maxVelocityStep, const double softeningLength,
+    float* potentialEnergy);
+template bool integrate<double, float>(
+    std::vector<Vector2D<float>>& particleAccelerations,
+    std::vector<Particle<double>>& particles, double& timeStep,
+    const std::string& integrationMethod, const bool enableAdaptiveTimeStep,
+    const double maxVelocityStep, const double softeningLength,
+    double* potentialEnergy);
+template double getPotentialEnergy(const std::vector<Particle<double>>& particles,
+                                   const double softeningLength);
+template float getPotentialEnergy(const std::vector<Particle<float>>& particles,
+                                  const double softeningLength);
+template double getKineticEnergy(const std::vector<Particle<double>>& particles);
+template float getKineticEnergy(const std::vector<Particle<float>>& particles);
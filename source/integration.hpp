@@ -0,0 +1,27 @@
+#pragma once
+
+#include "particle.hpp"
+#include "vector2d.hpp"
+
+#include <vector>
+#include <string>
+
+// T is the scalar type the particle state is stored and integrated in, F the one the
+// pairwise forces are evaluated in (see ParticleSystem). softeningLength is the Plummer
+// softening length of the gravity (0 for Newtonian gravity; see Particle).
+
+template <typename T, typename F>
+std::vector<Vector2D<F>>
+calculateAccelerations(const std::vector<Particle<T>>& particles, double& timeStep,
+                       const bool enableAdaptiveTimeStep, const double maxVelocityStep,
+                       const double softeningLength, T* potentialEnergy = nullptr);
+template <typename T, typename F>
+bool integrate(std::vector<Vector2D<F>>& particleAccelerations,
+               std::vector<Particle<T>>& particles, double& timeStep,
+               const std::string& integrationMethod, const bool enableAdaptiveTimeStep,
+               const double maxVelocityStep, const double softeningLength,
+               T* potentialEnergy);
+template <typename T>
+T getPotentialEnergy(const std::vector<Particle<T>>& particles,
+                     const double softeningLength);
+template <typename T> T getKineticEnergy(const std::vector<Particle<T>>& particles);
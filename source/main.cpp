@@ -1,44 +1,170 @@
+#include "autotuner.hpp"
 #include "config.hpp"
 #include "util.hpp"
-#include "particle_system.hpp"
+#include "shard.hpp"
+#include "simulation_runner.hpp"
 
 #include <iostream>
 #include <filesystem>
-#include <memory>
+#include <format>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 #define CONFIG_PATH "../config.txt"
+#define PERFORMANCE_REPORT_SLOWEST_SYSTEMS 10
+#define SHARD_INDEX_FILE_NAME "index.json"
 
-int main() {
-    const Config config = Config::load(CONFIG_PATH);
+class CommandLineOptions {
+    public:
+        std::filesystem::path configPath = CONFIG_PATH;
+        std::optional<unsigned long> shardIndex;
+        bool merge = false;
+        std::optional<std::filesystem::path> autotuneConfigPath;
+};
 
-    std::cout << "Simulations started at: " << getDateTimeString(false, 0) << std::endl;
-    std::cout << "Output directory: " << config.outputDirPath << '\n' << std::endl;
+static CommandLineOptions parseArguments(const int argc, const char* const argv[]);
+static int runAutotune(
+    const CommandLineOptions& options, const Config& config,
+    const std::vector<std::filesystem::directory_entry>& inputFileEntries);
+static std::filesystem::path getShardFilePath(const std::filesystem::path& filePath,
+                                              const Shard& shard);
 
+// Usage: gravity-simulation [<config-file>] [--shard-index <index>] [--merge]
+//                           [--autotune <output-config-file>]
+// (default config file: ../config.txt)
+int main(const int argc, const char* const argv[]) {
+    const CommandLineOptions options = parseArguments(argc, argv);
+    const Config config = Config::load(options.configPath);
     const auto inputFileEntries = getFileEntries(config.inputFilesDirPath);
-    const size_t inputFileCount = inputFileEntries.size();
-    const std::shared_ptr<const UnitSystem> sharedUnitSystem
-        = std::make_shared<const UnitSystem>(config.unitSystem);
-    size_t progress = 0;
-
-#ifdef _OPENMP
-    #pragma omp parallel for
-#endif
-    for (const auto& fileEntry : inputFileEntries) {
-        ParticleSystem particleSystem(fileEntry.path(), sharedUnitSystem);
-
-        particleSystem.simulate(config.fixedTimeStep, config.outputDirPath,
-                                config.enableAdaptiveTimeStep, config.maxVelocityStep,
-                                config.maxTime, config.maxIterations,
-                                config.writeStatePeriod, config.integrationMethod);
-
-#ifdef _OPENMP
-    #pragma omp critical
-#endif
-        {
-            progress++;
-            printProgress(progress, inputFileCount);
+
+    if (options.merge) {
+        const bool isComplete = mergeShardManifests(
+            config.shardManifestDirPath, inputFileEntries,
+            config.shardManifestDirPath / SHARD_INDEX_FILE_NAME);
+
+        return isComplete ? 0 : 1;
+    }
+
+    if (options.autotuneConfigPath)
+        return runAutotune(options, config, inputFileEntries);
+
+    const Shard shard(config.shardMode, options.shardIndex.value_or(config.shardIndex),
+                      config.shardCount);
+    const auto shardFileEntries = shard.selectFileEntries(inputFileEntries);
+
+    std::cout << "Simulations started at: " << getDateTimeString(false, 0) << std::endl;
+    std::cout << "Output directory: " << config.outputDirPath << std::endl;
+
+    if (shard.count > 1)
+        std::cout << "Shard: " << shard.index + 1 << "/" << shard.count << " ("
+                  << shard.mode << ", " << shardFileEntries.size() << " of "
+                  << inputFileEntries.size() << " systems)" << std::endl;
+
+    const ThreadPlacement threadPlacement(NumaTopology::read(), config.threadPlacement,
+                                          getThreadCount());
+
+    std::cout << "Thread placement: " << threadPlacement.getSummary() << '\n'
+              << std::endl;
+
+    PerformanceReport performanceReport(getThreadCount());
+    ShardManifest shardManifest(shard, inputFileEntries.size(),
+                                shardFileEntries.size());
+    // Unsharded runs have nothing to merge
+    const bool isSharded = shard.count > 1;
+
+    const std::vector<int> outcomes = simulateSystems(
+        config, config.precision, shardFileEntries, config.outputDirPath,
+        &performanceReport, isSharded ? &shardManifest : nullptr, &threadPlacement);
+
+    if (isSharded || !config.performanceReportPath.empty()) std::cout << std::endl;
+
+    if (!config.performanceReportPath.empty()) {
+        const std::filesystem::path performanceReportPath
+            = getShardFilePath(config.performanceReportPath, shard);
+
+        performanceReport.write(performanceReportPath,
+                                PERFORMANCE_REPORT_SLOWEST_SYSTEMS);
+
+        std::cout << "Performance report: " << performanceReportPath << std::endl;
+    }
+
+    if (isSharded) {
+        const std::filesystem::path shardManifestPath
+            = config.shardManifestDirPath / (shard.getName() + ".json");
+
+        shardManifest.write(shardManifestPath);
+
+        std::cout << "Shard manifest: " << shardManifestPath << std::endl;
+    }
+
+    if (config.precision != "double" && config.precisionValidationSamples > 0)
+        validatePrecision(config, shardFileEntries, outcomes);
+
+    return 0;
+}
+
+static CommandLineOptions parseArguments(const int argc, const char* const argv[]) {
+    CommandLineOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--shard-index" && hasValue) {
+            options.shardIndex = std::stoul(argv[++i]);
+        } else if (argument == "--merge") {
+            options.merge = true;
+        } else if (argument == "--autotune" && hasValue) {
+            options.autotuneConfigPath = argv[++i];
+        } else if (!argument.starts_with("--")) {
+            options.configPath = argument;
+        } else {
+            throw std::invalid_argument("Invalid argument: '" + argument + "'");
         }
     }
 
+    return options;
+}
+
+// Writes the config with the autotuned settings, returns the exit code
+static int runAutotune(
+    const CommandLineOptions& options, const Config& config,
+    const std::vector<std::filesystem::directory_entry>& inputFileEntries) {
+    const std::optional<AutotuneSetting> setting = autotune(config, inputFileEntries);
+
+    if (!setting) {
+        std::cout << "\nNo setting is within the accuracy budget" << std::endl;
+
+        return 1;
+    }
+
+    Config::writeUpdated(options.configPath, *options.autotuneConfigPath,
+                         {{"integrationMethod", setting->integrationMethod},
+                          {"fixedTimeStep", std::format("{}", setting->fixedTimeStep)},
+                          {"maxVelocityStep",
+                           std::format("{}", setting->maxVelocityStep)}});
+
+    std::cout << "\nChosen: " << setting->integrationMethod
+              << " (fixedTimeStep: " << setting->fixedTimeStep
+              << ", maxVelocityStep: " << setting->maxVelocityStep << ", "
+              << setting->forceEvaluationsPerTime << " force evaluations per time)"
+              << std::endl;
+    std::cout << "Config written to: " << *options.autotuneConfigPath << std::endl;
+
     return 0;
 }
+
+// Appends the shard name to the file name if there is more than one shard, so that
+// shards running on a shared file system do not overwrite each other's files
+static std::filesystem::path getShardFilePath(const std::filesystem::path& filePath,
+                                              const Shard& shard) {
+    if (shard.count == 1) return filePath;
+
+    std::filesystem::path shardFilePath = filePath;
+
+    shardFilePath.replace_filename(filePath.stem().string() + "." + shard.getName()
+                                   + filePath.extension().string());
+
+    return shardFilePath;
+}
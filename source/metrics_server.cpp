@@ -0,0 +1,157 @@
+#include "metrics_server.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define HAS_UNIX_SOCKETS
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#define METRICS_SLOWEST_SYSTEMS 10
+#define METRICS_CONNECTION_BACKLOG 8
+// How long the server thread may take to notice that it should stop
+#define METRICS_POLL_TIMEOUT_MS 100
+// A client which does not read its snapshot is dropped after this time
+#define METRICS_SEND_TIMEOUT_SECONDS 1
+
+#if defined(HAS_UNIX_SOCKETS) && !defined(MSG_NOSIGNAL)
+    #define MSG_NOSIGNAL 0
+#endif
+
+#ifdef HAS_UNIX_SOCKETS
+static bool isSocketListening(const sockaddr_un& address);
+#endif
+
+MetricsServer::MetricsServer(const std::filesystem::path& socketPath,
+                             const ProgressReporter& progressReporter)
+    : socketPath(socketPath)
+    , progressReporter(progressReporter) {
+#ifdef HAS_UNIX_SOCKETS
+    sockaddr_un address {};
+    const std::string socketPathString = socketPath.string();
+
+    if (socketPathString.size() >= sizeof address.sun_path)
+        throw std::invalid_argument("Metrics socket: path '" + socketPathString
+                                    + "' is too long");
+
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, socketPathString.c_str());
+
+    // A socket file left behind by a crashed run would make bind() fail. It is only
+    // replaced if nothing listens on it, so that concurrent runs (e.g. shards) with
+    // the same path don't take over each other's socket.
+    const std::filesystem::file_status socketStatus
+        = std::filesystem::symlink_status(socketPath);
+
+    if (std::filesystem::exists(socketStatus)) {
+        if (!std::filesystem::is_socket(socketStatus))
+            throw std::invalid_argument("Metrics socket: '" + socketPathString
+                                        + "' exists and is not a socket");
+
+        if (isSocketListening(address))
+            throw std::runtime_error("Metrics socket: '" + socketPathString
+                                     + "' is in use by another process");
+
+        std::filesystem::remove(socketPath);
+    }
+
+    socketDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (socketDescriptor < 0)
+        throw std::system_error(errno, std::generic_category(),
+                                "Metrics socket: could not be created");
+
+    if (bind(socketDescriptor, reinterpret_cast<const sockaddr*>(&address),
+             sizeof address)
+            < 0
+        || listen(socketDescriptor, METRICS_CONNECTION_BACKLOG) < 0) {
+        const int error = errno;
+
+        close(socketDescriptor);
+
+        throw std::system_error(error, std::generic_category(),
+                                "Metrics socket: could not listen on '"
+                                    + socketPathString + "'");
+    }
+
+    serverThread = std::thread(&MetricsServer::run, this);
+#else
+    throw std::runtime_error("Metrics socket: Unix domain sockets are not supported "
+                             "on this platform");
+#endif
+}
+
+MetricsServer::~MetricsServer() {
+#ifdef HAS_UNIX_SOCKETS
+    isStopping = true;
+    serverThread.join();
+
+    close(socketDescriptor);
+
+    // Destructors must not throw, and a missing socket file is no reason to
+    std::error_code errorCode;
+    std::filesystem::remove(socketPath, errorCode);
+#endif
+}
+
+// Clients are served one after the other, as a snapshot only takes microseconds
+void MetricsServer::run() {
+#ifdef HAS_UNIX_SOCKETS
+    pollfd pollDescriptor { socketDescriptor, POLLIN, 0 };
+
+    while (!isStopping) {
+        if (poll(&pollDescriptor, 1, METRICS_POLL_TIMEOUT_MS) <= 0) continue;
+
+        const int clientDescriptor = accept(socketDescriptor, nullptr, nullptr);
+
+        if (clientDescriptor < 0) continue;
+
+        const timeval sendTimeout { METRICS_SEND_TIMEOUT_SECONDS, 0 };
+        setsockopt(clientDescriptor, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout,
+                   sizeof sendTimeout);
+
+        const std::string metrics
+            = progressReporter.getMetrics(METRICS_SLOWEST_SYSTEMS);
+        size_t sentSize = 0;
+
+        while (sentSize < metrics.size()) {
+            const ssize_t chunkSize = send(clientDescriptor, metrics.data() + sentSize,
+                                           metrics.size() - sentSize, MSG_NOSIGNAL);
+
+            if (chunkSize <= 0) break;
+
+            sentSize += static_cast<size_t>(chunkSize);
+        }
+
+        close(clientDescriptor);
+    }
+#endif
+}
+
+#ifdef HAS_UNIX_SOCKETS
+static bool isSocketListening(const sockaddr_un& address) {
+    // A failed connect() leaves the socket in an unspecified state, so a separate
+    // socket is used for probing
+    const int probeDescriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (probeDescriptor < 0)
+        throw std::system_error(errno, std::generic_category(),
+                                "Metrics socket: could not be created");
+
+    const bool isListening = connect(probeDescriptor,
+                                     reinterpret_cast<const sockaddr*>(&address),
+                                     sizeof address)
+        == 0;
+
+    close(probeDescriptor);
+
+    return isListening;
+}
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "progress_reporter.hpp"
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+
+// Serves the metrics of a ProgressReporter on a Unix domain socket from a background
+// thread (POSIX only): every client which connects receives a single snapshot in the
+// Prometheus text format, after which the connection is closed. An existing file at
+// socketPath is replaced, and the socket is removed again on destruction.
+class MetricsServer {
+    public:
+        MetricsServer(const std::filesystem::path& socketPath,
+                      const ProgressReporter& progressReporter);
+        ~MetricsServer();
+
+    private:
+        const std::filesystem::path socketPath;
+        const ProgressReporter& progressReporter;
+        int socketDescriptor = -1;
+        std::atomic<bool> isStopping = false;
+        std::thread serverThread;
+
+        void run();
+};
@@ -0,0 +1,228 @@
+#include "numa_topology.hpp"
+
+#include "util.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <set>
+#include <stdexcept>
+
+#ifdef __linux__
+    #include <sched.h>
+#endif
+
+#define NUMA_NODE_DIR_PATH "/sys/devices/system/node"
+#define NUMA_NODE_PREFIX "node"
+
+static std::vector<int> parseCpuList(const std::string& cpuList);
+static std::string formatCpuList(std::vector<int> cpus);
+static bool isAllowedCpu(const int cpu);
+static std::vector<int> getAllowedCpus();
+
+NumaTopology NumaTopology::read() {
+    NumaTopology topology;
+
+    if (!std::filesystem::is_directory(NUMA_NODE_DIR_PATH)) return topology;
+
+    std::vector<std::pair<int, std::vector<int>>> nodes;
+
+    const std::filesystem::directory_iterator dirIterator(NUMA_NODE_DIR_PATH);
+
+    for (const auto& dirEntry : dirIterator) {
+        const std::string dirName = dirEntry.path().filename().string();
+        const std::string nodeIdString = dirName.substr(sizeof NUMA_NODE_PREFIX - 1);
+
+        if (!dirName.starts_with(NUMA_NODE_PREFIX) || nodeIdString.empty()
+            || !std::all_of(nodeIdString.begin(), nodeIdString.end(), ::isdigit))
+            continue;
+
+        std::ifstream cpuListFile(dirEntry.path() / "cpulist");
+        std::string cpuList;
+        std::vector<int> cpus;
+
+        std::getline(cpuListFile, cpuList);
+
+        for (const int cpu : parseCpuList(cpuList)) {
+            if (isAllowedCpu(cpu)) cpus.push_back(cpu);
+        }
+
+        // Memory-only nodes and nodes outside of the affinity mask (e.g. set by a batch
+        // scheduler) can't run any threads
+        if (!cpus.empty()) nodes.emplace_back(std::stoi(nodeIdString), cpus);
+    }
+
+    std::sort(nodes.begin(), nodes.end());
+
+    for (const auto& [nodeId, cpus] : nodes) {
+        topology.nodeIds.push_back(nodeId);
+        topology.nodeCpus.push_back(cpus);
+    }
+
+    return topology;
+}
+
+ThreadPlacement::ThreadPlacement(const NumaTopology& topology,
+                                 const std::string& policy, const int threadCount)
+    : topology(topology)
+    , policy(policy) {
+    if (policy != "none" && policy != "spread" && policy != "compact")
+        throw std::invalid_argument(
+            std::format("Unknown thread placement: '{}'", policy));
+
+    if (policy == "none" || topology.nodeIds.empty()) return;
+
+    allowedCpus = getAllowedCpus();
+
+    const size_t nodeCount = topology.nodeIds.size();
+    std::vector<std::pair<size_t, int>> compactCpus;
+
+    for (size_t i = 0; i < nodeCount; i++) {
+        for (const int cpu : topology.nodeCpus[i]) {
+            compactCpus.emplace_back(i, cpu);
+        }
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(threadCount); i++) {
+        if (policy == "spread") {
+            const size_t node = i % nodeCount;
+            const std::vector<int>& cpus = topology.nodeCpus[node];
+
+            threadNodes.push_back(node);
+            threadCpus.push_back(cpus[i / nodeCount % cpus.size()]);
+        } else {
+            const auto& [node, cpu] = compactCpus[i % compactCpus.size()];
+
+            threadNodes.push_back(node);
+            threadCpus.push_back(cpu);
+        }
+    }
+}
+
+bool ThreadPlacement::pinThread(const int threadIndex) const {
+    if (threadCpus.empty()) return policy == "none";
+
+#ifdef __linux__
+    cpu_set_t cpuSet;
+
+    CPU_ZERO(&cpuSet);
+    CPU_SET(threadCpus[threadIndex], &cpuSet);
+
+    return sched_setaffinity(0, sizeof cpuSet, &cpuSet) == 0;
+#else
+    return false;
+#endif
+}
+
+void ThreadPlacement::unpinThread() const {
+    if (allowedCpus.empty()) return;
+
+#ifdef __linux__
+    cpu_set_t cpuSet;
+
+    CPU_ZERO(&cpuSet);
+
+    for (const int cpu : allowedCpus) {
+        CPU_SET(cpu, &cpuSet);
+    }
+
+    sched_setaffinity(0, sizeof cpuSet, &cpuSet);
+#endif
+}
+
+std::string ThreadPlacement::getSummary() const {
+    if (policy == "none")
+        return std::format("left to the OS ({} NUMA nodes)", topology.nodeIds.size());
+
+    if (threadCpus.empty()) return "not supported (no NUMA topology found)";
+
+    std::string summary = std::format("{} over {} NUMA nodes (", policy,
+                                      topology.nodeIds.size());
+
+    for (size_t i = 0; i < topology.nodeIds.size(); i++) {
+        std::vector<int> nodeThreadCpus;
+
+        for (size_t j = 0; j < threadCpus.size(); j++) {
+            if (threadNodes[j] == i) nodeThreadCpus.push_back(threadCpus[j]);
+        }
+
+        summary += std::format("{}node {}: {} threads", i ? ", " : "",
+                               topology.nodeIds[i], nodeThreadCpus.size());
+
+        if (!nodeThreadCpus.empty())
+            summary += " on CPUs " + formatCpuList(nodeThreadCpus);
+    }
+
+    return summary + ")";
+}
+
+// Parses the kernel's CPU list format, e.g. "0-3,8-11"
+static std::vector<int> parseCpuList(const std::string& cpuList) {
+    std::vector<int> cpus;
+
+    for (const std::string& range : splitStringByDelimiter(cpuList, ',')) {
+        if (range.empty()) continue;
+
+        const std::vector<std::string> bounds = splitStringByDelimiter(range, '-');
+        const int first = std::stoi(bounds.front());
+        const int last = std::stoi(bounds.back());
+
+        for (int cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+static std::string formatCpuList(std::vector<int> cpus) {
+    const std::set<int> uniqueCpus(cpus.begin(), cpus.end());
+
+    cpus.assign(uniqueCpus.begin(), uniqueCpus.end());
+
+    std::string cpuList;
+
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            j++;
+        }
+
+        cpuList += (cpuList.empty() ? "" : ",") + std::to_string(cpus[i])
+            + (j > i ? "-" + std::to_string(cpus[j]) : "");
+        i = j + 1;
+    }
+
+    return cpuList;
+}
+
+// Whether the process may run on cpu according to its affinity mask
+static bool isAllowedCpu(const int cpu) {
+#ifdef __linux__
+    cpu_set_t cpuSet;
+
+    if (sched_getaffinity(0, sizeof cpuSet, &cpuSet) != 0) return true;
+
+    return CPU_ISSET(cpu, &cpuSet);
+#else
+    return true;
+#endif
+}
+
+// CPUs the calling thread may run on according to its affinity mask (empty if unknown)
+static std::vector<int> getAllowedCpus() {
+    std::vector<int> cpus;
+
+#ifdef __linux__
+    cpu_set_t cpuSet;
+
+    if (sched_getaffinity(0, sizeof cpuSet, &cpuSet) != 0) return cpus;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &cpuSet)) cpus.push_back(cpu);
+    }
+#endif
+
+    return cpus;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// NUMA nodes with the CPUs this process may run on, read from /sys/devices/system/node
+// (Linux only; elsewhere there are no nodes). Must be read before any thread is pinned,
+// as pinning narrows the CPUs the process may run on.
+class NumaTopology {
+    public:
+        std::vector<int> nodeIds;
+        std::vector<std::vector<int>> nodeCpus; // same order as nodeIds
+
+        static NumaTopology read();
+};
+
+// Assignment of worker threads to CPUs: "spread" distributes consecutive threads
+// round-robin over the NUMA nodes, "compact" fills one node after the other and "none"
+// leaves the placement to the OS (and OMP_PROC_BIND)
+class ThreadPlacement {
+    public:
+        ThreadPlacement(const NumaTopology& topology, const std::string& policy,
+                        const int threadCount);
+
+        // Pins the calling thread to the CPU of threadIndex. Returns false if that
+        // failed or is not supported.
+        bool pinThread(const int threadIndex) const;
+        // Lets the calling thread run on all CPUs again which the constructing thread
+        // could run on
+        void unpinThread() const;
+        // e.g. "spread over 2 NUMA nodes (node 0: 4 threads on CPUs 0-3, node 1: ...)"
+        std::string getSummary() const;
+
+    private:
+        const NumaTopology topology;
+        const std::string policy;
+        std::vector<int> threadCpus;
+        std::vector<size_t> threadNodes; // indices into topology.nodeIds
+        std::vector<int> allowedCpus;
+};
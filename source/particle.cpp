@@ -1,37 +1,113 @@
 #include "particle.hpp"
 
-Particle::Particle(const double mass, const Vector2D& position,
-                   const Vector2D& velocity,
-                   const std::shared_ptr<const UnitSystem> unitSystem)
+#include <cmath>
+
+template <typename T>
+Particle<T>::Particle(const T mass, const Vector2D<T>& position,
+                      const Vector2D<T>& velocity,
+                      const std::shared_ptr<const UnitSystem> unitSystem)
     : mass(mass)
     , position(position)
     , velocity(velocity)
     , unitSystem(unitSystem) {
 }
 
-double Particle::getKineticEnergy() const {
-    const double absVelocity = velocity.abs();
+template <typename T> T Particle<T>::getKineticEnergy() const {
+    const T absVelocity = velocity.abs();
+
+    return static_cast<T>(0.5) * mass * absVelocity * absVelocity;
+}
+
+template <typename T>
+T Particle<T>::getPotentialEnergy(const Particle& particle,
+                                  const T softeningSquared) const {
+    const Vector2D<T> distance = position - particle.position;
 
-    return 0.5 * mass * absVelocity * absVelocity;
+    return -static_cast<T>(unitSystem->gravityConstant) * mass * particle.mass
+        / std::sqrt(distance.dotProduct(distance) + softeningSquared);
 }
 
-double Particle::getPotentialEnergy(const Particle& particle) const {
-    return -unitSystem->gravityConstant * mass * particle.mass
-        / (position - particle.position).abs();
+// The distance is calculated in T before converting it to F, so that a lower precision
+// F does not suffer from cancellation of the (larger) absolute positions
+template <typename T>
+template <typename F>
+Vector2D<F> Particle<T>::getGravityAccelerationFactor(const Particle& particle,
+                                                      const F softeningSquared) const {
+    const Vector2D<F> distance(position - particle.position);
+    const F absDistance = std::sqrt(distance.dotProduct(distance) + softeningSquared);
+
+    return -static_cast<F>(unitSystem->gravityConstant)
+        / (absDistance * absDistance * absDistance) * distance;
 }
 
-Vector2D Particle::getGravityAccelerationFactor(const Particle& particle) const {
-    const Vector2D distance = position - particle.position;
-    const double absDistance = distance.abs();
+// Same as above, but also returns -G / r in potentialFactor so that the pair's
+// potential energy (potentialFactor * m1 * m2) can be accumulated without another sqrt
+template <typename T>
+template <typename F>
+Vector2D<F> Particle<T>::getGravityAccelerationFactor(const Particle& particle,
+                                                      const F softeningSquared,
+                                                      F& potentialFactor) const {
+    const Vector2D<F> distance(position - particle.position);
+    const F absDistance = std::sqrt(distance.dotProduct(distance) + softeningSquared);
+    const F gravityConstant = static_cast<F>(unitSystem->gravityConstant);
+
+    potentialFactor = -gravityConstant / absDistance;
 
-    return -unitSystem->gravityConstant / (absDistance * absDistance * absDistance)
-        * distance;
+    return -gravityConstant / (absDistance * absDistance * absDistance) * distance;
 }
 
-void Particle::updatePosition(const Vector2D& velocity, const double timeStep) {
+template <typename T>
+void Particle<T>::updatePosition(const Vector2D<T>& velocity, const T timeStep) {
     position = position + velocity * timeStep;
 }
 
-void Particle::updateVelocity(const Vector2D& acceleration, const double timeStep) {
-    velocity = velocity + acceleration * timeStep;
+template <typename T>
+template <typename F>
+void Particle<T>::updateVelocity(const Vector2D<F>& acceleration, const T timeStep) {
+    velocity = velocity + Vector2D<T>(acceleration) * timeStep;
 }
+
+template <typename T> Particle<T> Particle<T>::merge(const Particle& particle) const {
+    const T totalMass = mass + particle.mass;
+
+    // Massless (tracer) particles have no centre of mass
+    if (totalMass == 0)
+        return Particle(totalMass, (position + particle.position) / static_cast<T>(2),
+                        (velocity + particle.velocity) / static_cast<T>(2), unitSystem);
+
+    return Particle(totalMass,
+                    (mass * position + particle.mass * particle.position) / totalMass,
+                    (mass * velocity + particle.mass * particle.velocity) / totalMass,
+                    unitSystem);
+}
+
+template class Particle<double>;
+template class Particle<float>;
+
+template Vector2D<double>
+Particle<double>::getGravityAccelerationFactor(const Particle& particle,
+                                               const double softeningSquared) const;
+template Vector2D<float>
+Particle<double>::getGravityAccelerationFactor(const Particle& particle,
+                                               const float softeningSquared) const;
+template Vector2D<float>
+Particle<float>::getGravityAccelerationFactor(const Particle& particle,
+                                              const float softeningSquared) const;
+template Vector2D<double>
+Particle<double>::getGravityAccelerationFactor(const Particle& particle,
+                                               const double softeningSquared,
+                                               double& potentialFactor) const;
+template Vector2D<float>
+Particle<double>::getGravityAccelerationFactor(const Particle& particle,
+                                               const float softeningSquared,
+                                               float& potentialFactor) const;
+template Vector2D<float>
+Particle<float>::getGravityAccelerationFactor(const Particle& particle,
+                                              const float softeningSquared,
+                                              float& potentialFactor) const;
+template void Particle<double>::updateVelocity(const Vector2D<double>& acceleration,
+                                               const double timeStep);
+template void Particle<double>::updateVelocity(const Vector2D<float>& acceleration,
+                                               const double timeStep);
+template void Particle<float>::updateVelocity(const Vector2D<float>& acceleration,
+                                              const float timeStep);
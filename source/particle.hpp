@@ -5,20 +5,37 @@
 
 #include <memory>
 
-class Particle {
+// T is the scalar type the particle state is stored in. The gravity acceleration
+// factors can be evaluated in a different scalar type F (e.g. float forces for a double
+// state).
+template <typename T> class Particle {
     public:
-        const double mass;
-        Vector2D position;
-        Vector2D velocity;
+        const T mass;
+        Vector2D<T> position;
+        Vector2D<T> velocity;
 
-        Particle(const double mass, const Vector2D& position, const Vector2D& velocity,
+        Particle(const T mass, const Vector2D<T>& position, const Vector2D<T>& velocity,
                  const std::shared_ptr<const UnitSystem> unitSystem);
 
-        double getKineticEnergy() const;
-        double getPotentialEnergy(const Particle& particle) const;
-        Vector2D getGravityAccelerationFactor(const Particle& particle) const;
-        void updatePosition(const Vector2D& velocity, const double timeStep);
-        void updateVelocity(const Vector2D& acceleration, const double timeStep);
+        T getKineticEnergy() const;
+        // The gravity between two particles is softened by the Plummer softening length
+        // epsilon (0 for Newtonian gravity), i.e. the distance r is replaced by
+        // sqrt(r^2 + epsilon^2), and softeningSquared is epsilon^2
+        T getPotentialEnergy(const Particle& particle, const T softeningSquared) const;
+        template <typename F>
+        Vector2D<F> getGravityAccelerationFactor(const Particle& particle,
+                                                 const F softeningSquared) const;
+        template <typename F>
+        Vector2D<F> getGravityAccelerationFactor(const Particle& particle,
+                                                 const F softeningSquared,
+                                                 F& potentialFactor) const;
+        void updatePosition(const Vector2D<T>& velocity, const T timeStep);
+        template <typename F>
+        void updateVelocity(const Vector2D<F>& acceleration, const T timeStep);
+        // Particle formed by a perfectly inelastic collision with particle, i.e. with
+        // their total mass and momentum at their centre of mass (or with their mean
+        // position and velocity if their total mass is 0)
+        Particle merge(const Particle& particle) const;
 
     private:
         const std::shared_ptr<const UnitSystem> unitSystem;
@@ -1,9 +1,17 @@
 #include "particle_system.hpp"
 
+#include "collisions.hpp"
+#include "integration.hpp"
+#include "state_output.hpp"
 #include "util.hpp"
 
+#include <chrono>
+#include <format>
 #include <fstream>
 #include <memory>
+#include <cmath>
+#include <limits>
+#include <numeric>
 
 #define INPUT_FILE_DELIMITER ' '
 #define INPUT_FILE_MASS_INDEX 0
@@ -13,22 +21,14 @@
 #define INPUT_FILE_VELOCITY_Y_INDEX 4
 #define OUTPUT_FILE_SUFFIX "_output.txt"
 
-static std::vector<Vector2D>
-calculateAccelerations(const std::vector<Particle>& particles, double& timeStep,
-                       const bool enableAdaptiveTimeStep, const double maxVelocityStep);
-static void writeState(std::ofstream& outputFile, const double currentTime,
-                       const std::vector<Particle>& particles);
-static std::string getMassPosVelString(const std::vector<Particle>& particles);
-static double getSystemEnergy(const std::vector<Particle>& particles);
-static void integrate(std::vector<Vector2D>& particleAccelerations,
-                      std::vector<Particle>& particles, double& timeStep,
-                      const std::string& integrationMethod,
-                      const bool enableAdaptiveTimeStep, const double maxVelocityStep);
-
-ParticleSystem::ParticleSystem(
+template <typename T, typename F>
+ParticleSystem<T, F>::ParticleSystem(
     const std::filesystem::path& inputFilePath,
     const std::shared_ptr<const UnitSystem> simulationUnitSystem)
     : inputFileStem(inputFilePath.stem().string()) {
+    const std::chrono::steady_clock::time_point startTime
+        = std::chrono::steady_clock::now();
+
     std::string line;
     std::ifstream inputFile = loadTextFile(inputFilePath);
 
@@ -51,211 +51,409 @@ ParticleSystem::ParticleSystem(
         const double velocityY = simulationUnitSystem->convertVelocity(
             stod(lineSegments[INPUT_FILE_VELOCITY_Y_INDEX]), fileUnitSystem);
 
-        particles.push_back(Particle(mass, Vector2D(positionX, positionY),
-                                     Vector2D(velocityX, velocityY),
-                                     simulationUnitSystem));
+        particles.push_back(Particle<T>(
+            static_cast<T>(mass),
+            Vector2D<T>(static_cast<T>(positionX), static_cast<T>(positionY)),
+            Vector2D<T>(static_cast<T>(velocityX), static_cast<T>(velocityY)),
+            simulationUnitSystem));
     }
+
+    if (particles.empty())
+        throw std::invalid_argument(
+            format("Particle system: '{}' needs at least 1 particle", inputFileStem));
+
+    particleIds.resize(particles.size());
+    std::iota(particleIds.begin(), particleIds.end(), 0);
+
+    stats.name = inputFileStem;
+    stats.systemCount = 1;
+    stats.parseSeconds = getSecondsSince(startTime);
+    stats.wallSeconds = stats.parseSeconds;
+}
+
+template <typename T, typename F>
+ParticleSystem<T, F>::ParticleSystem(
+    const std::string& name, std::span<const double> masses,
+    std::span<const double> positions, std::span<const double> velocities,
+    const std::shared_ptr<const UnitSystem> simulationUnitSystem)
+    : inputFileStem(name) {
+    const size_t particleCount = masses.size();
+
+    if (particleCount == 0)
+        throw std::invalid_argument(
+            format("Particle system: '{}' needs at least 1 particle", name));
+
+    if (positions.size() != 2 * particleCount || velocities.size() != 2 * particleCount)
+        throw std::invalid_argument(
+            format("Particle system: '{}' needs 2 position and 2 velocity values per "
+                   "particle",
+                   name));
+
+    particles.reserve(particleCount);
+
+    for (size_t i = 0; i < particleCount; i++) {
+        particles.push_back(Particle<T>(
+            static_cast<T>(masses[i]),
+            Vector2D<T>(static_cast<T>(positions[2 * i]),
+                        static_cast<T>(positions[2 * i + 1])),
+            Vector2D<T>(static_cast<T>(velocities[2 * i]),
+                        static_cast<T>(velocities[2 * i + 1])),
+            simulationUnitSystem));
+    }
+
+    particleIds.resize(particleCount);
+    std::iota(particleIds.begin(), particleIds.end(), 0);
+
+    stats.name = inputFileStem;
+    stats.systemCount = 1;
 }
 
-void ParticleSystem::simulate(const double fixedTimeStep,
-                              const std::filesystem::path& outputDirPath,
-                              const bool enableAdaptiveTimeStep,
-                              const double maxVelocityStep, const double maxTime,
-                              const unsigned long maxIterations,
-                              const double writeStatePeriod,
-                              const std::string& integrationMethod) {
-    double timeStep = fixedTimeStep;
-    double currentTime = 0.0;
+template <typename T, typename F>
+void ParticleSystem<T, F>::simulate(const double fixedTimeStep,
+                                    const std::filesystem::path& outputDirPath,
+                                    const bool enableAdaptiveTimeStep,
+                                    const double maxVelocityStep, const double maxTime,
+                                    const unsigned long maxIterations,
+                                    const double writeStatePeriod,
+                                    const std::string& integrationMethod) {
+    const std::chrono::steady_clock::time_point startTime
+        = std::chrono::steady_clock::now();
+    const ForceCounters initialForceCounters = threadForceCounters;
+    const double initialWriteSeconds = stats.writeSeconds;
 
     int writeStateCounter = 0;
     unsigned long iterationCounter = 0;
 
     std::ofstream outputFile
-        = createOutputFile(outputDirPath / (inputFileStem + OUTPUT_FILE_SUFFIX));
+        = createOutputFile(getOutputFilePath(outputDirPath));
+
+    // Potential energy of the current state, if the last force pass produced it
+    T potentialEnergy = 0.0;
+    bool hasPotentialEnergy = true;
+
+    initializeIntegration(fixedTimeStep, enableAdaptiveTimeStep, maxVelocityStep,
+                          &potentialEnergy);
 
-    std::vector<Vector2D> particleAccelerations = calculateAccelerations(
-        particles, timeStep, enableAdaptiveTimeStep, maxVelocityStep);
+    const double initialEnergy = potentialEnergy + getKineticEnergy(particles);
+    maxEnergyDrift = 0.0;
+    mergerEnergyChange = 0.0;
+    reachedMaxIterations = false;
+    // The ids are increasing, so the particles are still those of the input unless
+    // some have been merged by earlier step() calls
+    areParticleIdsWritten
+        = particleIds.back() + 1 == static_cast<int>(particleIds.size());
+
+    if (liveStatus) liveStatus->maxTime.store(maxTime, std::memory_order_relaxed);
 
     while (currentTime <= maxTime) {
         if (currentTime >= static_cast<double>(writeStateCounter) * writeStatePeriod) {
-            writeState(outputFile, currentTime, particles);
+            recordState(outputFile, currentTime,
+                        hasPotentialEnergy ? &potentialEnergy : nullptr, initialEnergy);
             writeStateCounter++;
         }
 
-        integrate(particleAccelerations, particles, timeStep, integrationMethod,
-                  enableAdaptiveTimeStep, maxVelocityStep);
-
-        currentTime += timeStep;
+        // Only request the potential energy from the force pass if the next state is
+        // (probably) going to be written. With an adaptive time step this is only a
+        // prediction; recordState() computes the potential itself if it was wrong.
+        const bool isWriteStepAhead
+            = currentTime + timeStep
+                >= static_cast<double>(writeStateCounter) * writeStatePeriod
+            || (maxIterations > 0 && iterationCounter + 1 == maxIterations);
+
+        hasPotentialEnergy = integrateStep(
+            integrationMethod, fixedTimeStep, enableAdaptiveTimeStep, maxVelocityStep,
+            isWriteStepAhead ? &potentialEnergy : nullptr);
         iterationCounter++;
 
         if (maxIterations > 0 && iterationCounter == maxIterations) {
-            writeState(outputFile, -1.0, particles);
+            recordState(outputFile, -1.0,
+                        hasPotentialEnergy ? &potentialEnergy : nullptr, initialEnergy);
+            reachedMaxIterations = true;
 
             break;
         }
     }
+
+    const double simulateSeconds = getSecondsSince(startTime);
+
+    // Timing every step would be too expensive for small systems, so everything that
+    // is not writing is attributed to the integration
+    stats.addForceCounters(initialForceCounters, threadForceCounters);
+    stats.integrateSeconds
+        += simulateSeconds - (stats.writeSeconds - initialWriteSeconds);
+    stats.wallSeconds += simulateSeconds;
 }
 
-static std::vector<Vector2D>
-calculateAccelerations(const std::vector<Particle>& particles, double& timeStep,
-                       const bool enableAdaptiveTimeStep,
-                       const double maxVelocityStep) {
-    const size_t particleCount = particles.size();
-    std::vector<Vector2D> particleAccelerations(particleCount);
-    double maxAcceleration = 0.0;
-
-    for (size_t i = 0; i < particleCount - 1; i++) {
-        for (size_t j = i + 1; j < particleCount; j++) {
-            const Vector2D factor
-                = particles[i].getGravityAccelerationFactor(particles[j]);
-
-            particleAccelerations[i]
-                = particleAccelerations[i] + factor * particles[j].mass;
-            particleAccelerations[j]
-                = particleAccelerations[j] - factor * particles[i].mass;
-
-            if (enableAdaptiveTimeStep) {
-                if (particleAccelerations[i].abs() > maxAcceleration)
-                    maxAcceleration = particleAccelerations[i].abs();
-                if (particleAccelerations[j].abs() > maxAcceleration)
-                    maxAcceleration = particleAccelerations[j].abs();
-            }
-        }
+template <typename T, typename F>
+unsigned long ParticleSystem<T, F>::step(const unsigned long maxSteps,
+                                         const double maxTime,
+                                         const double fixedTimeStep,
+                                         const bool enableAdaptiveTimeStep,
+                                         const double maxVelocityStep,
+                                         const std::string& integrationMethod) {
+    const std::chrono::steady_clock::time_point startTime
+        = std::chrono::steady_clock::now();
+    const ForceCounters initialForceCounters = threadForceCounters;
+
+    if (particleAccelerations.empty())
+        initializeIntegration(fixedTimeStep, enableAdaptiveTimeStep, maxVelocityStep,
+                              nullptr);
+
+    unsigned long stepCounter = 0;
+
+    while (currentTime <= maxTime && (maxSteps == 0 || stepCounter < maxSteps)) {
+        integrateStep(integrationMethod, fixedTimeStep, enableAdaptiveTimeStep,
+                      maxVelocityStep, nullptr);
+        stepCounter++;
     }
 
-    if (enableAdaptiveTimeStep) timeStep = maxVelocityStep / maxAcceleration;
+    const double stepSeconds = getSecondsSince(startTime);
 
-    return particleAccelerations;
+    stats.addForceCounters(initialForceCounters, threadForceCounters);
+    stats.integrateSeconds += stepSeconds;
+    stats.wallSeconds += stepSeconds;
+
+    return stepCounter;
+}
+
+template <typename T, typename F>
+size_t ParticleSystem<T, F>::getParticleCount() const {
+    return particles.size();
+}
+
+template <typename T, typename F>
+double ParticleSystem<T, F>::getCurrentTime() const {
+    return currentTime;
+}
+
+template <typename T, typename F> double ParticleSystem<T, F>::getTimeStep() const {
+    return timeStep;
+}
+
+template <typename T, typename F> double ParticleSystem<T, F>::getEnergy() const {
+    return getPotentialEnergy(particles, softeningLength) + getKineticEnergy(particles);
 }
 
-static void writeState(std::ofstream& outputFile, const double currentTime,
-                       const std::vector<Particle>& particles) {
-    outputFile << currentTime << ", " << getMassPosVelString(particles) << ", "
-               << getSystemEnergy(particles) << std::endl;
+template <typename T, typename F>
+const std::vector<Particle<T>>& ParticleSystem<T, F>::getParticles() const {
+    return particles;
 }
 
-static std::string getMassPosVelString(const std::vector<Particle>& particles) {
+template <typename T, typename F>
+void ParticleSystem<T, F>::copyState(std::span<double> positions,
+                                     std::span<double> velocities) const {
     const size_t particleCount = particles.size();
-    std::stringstream massPosVelStream;
 
-    for (const Particle& particle : particles) {
-        massPosVelStream << particle.mass << ", ";
-    }
+    if ((!positions.empty() && positions.size() < 2 * particleCount)
+        || (!velocities.empty() && velocities.size() < 2 * particleCount))
+        throw std::invalid_argument(
+            format("Particle system: '{}' needs buffers of {} values for its state",
+                   inputFileStem, 2 * particleCount));
 
-    for (const Particle& particle : particles) {
-        massPosVelStream << particle.position << ", ";
-    }
+    for (size_t i = 0; i < particleCount; i++) {
+        if (!positions.empty()) {
+            positions[2 * i] = particles[i].position.x;
+            positions[2 * i + 1] = particles[i].position.y;
+        }
 
-    for (size_t i = 0; i < particleCount - 1; i++) {
-        massPosVelStream << particles[i].velocity << ", ";
+        if (!velocities.empty()) {
+            velocities[2 * i] = particles[i].velocity.x;
+            velocities[2 * i + 1] = particles[i].velocity.y;
+        }
     }
+}
 
-    massPosVelStream << particles[particleCount - 1].velocity;
-
-    return massPosVelStream.str();
+template <typename T, typename F>
+double ParticleSystem<T, F>::getMaxEnergyDrift() const {
+    return maxEnergyDrift;
 }
 
-static double getSystemEnergy(const std::vector<Particle>& particles) {
+template <typename T, typename F> int ParticleSystem<T, F>::getOutcome() const {
+    if (reachedMaxIterations) return -1;
+
     const size_t particleCount = particles.size();
-    double potentialEnergy = 0.0;
+    int outcome = 0;
+    T maxNeighbourDistance = 0.0;
+
+    for (size_t i = 0; i < particleCount; i++) {
+        T neighbourDistance = std::numeric_limits<T>::infinity();
+
+        for (size_t j = 0; j < particleCount; j++) {
+            if (i == j) continue;
 
-    for (size_t i = 0; i < particleCount - 1; i++) {
-        for (size_t j = i + 1; j < particleCount; j++) {
-            potentialEnergy += particles[i].getPotentialEnergy(particles[j]);
+            const T distance = (particles[i].position - particles[j].position).abs();
+
+            if (distance < neighbourDistance) neighbourDistance = distance;
+        }
+
+        if (neighbourDistance > maxNeighbourDistance) {
+            maxNeighbourDistance = neighbourDistance;
+            outcome = particleIds[i];
         }
     }
 
-    double kineticEnergy = 0.0;
+    return outcome;
+}
 
-    for (const Particle& particle : particles) {
-        kineticEnergy += particle.getKineticEnergy();
-    }
+template <typename T, typename F>
+const SimulationStats& ParticleSystem<T, F>::getStats() const {
+    return stats;
+}
 
-    return potentialEnergy + kineticEnergy;
+template <typename T, typename F>
+void ParticleSystem<T, F>::setInteraction(const double softeningLength,
+                                          const double collisionRadius) {
+    this->softeningLength = softeningLength;
+    this->collisionRadius = collisionRadius;
 }
 
-static void integrate(std::vector<Vector2D>& particleAccelerations,
-                      std::vector<Particle>& particles, double& timeStep,
-                      const std::string& integrationMethod,
-                      const bool enableAdaptiveTimeStep, const double maxVelocityStep) {
-    if (integrationMethod == "kdk") {
-        for (size_t i = 0; i < particles.size(); i++) {
-            particles[i].updateVelocity(particleAccelerations[i], 0.5 * timeStep);
-            particles[i].updatePosition(particles[i].velocity, timeStep);
-        }
+template <typename T, typename F>
+void ParticleSystem<T, F>::setLiveStatus(LiveSystemStatus* liveStatus) {
+    this->liveStatus = liveStatus;
+}
 
-        particleAccelerations = calculateAccelerations(
-            particles, timeStep, enableAdaptiveTimeStep, maxVelocityStep);
+template <typename T, typename F>
+uint64_t ParticleSystem<T, F>::getStateHash() const {
+    std::string stateBytes;
 
-        for (size_t i = 0; i < particles.size(); i++) {
-            particles[i].updateVelocity(particleAccelerations[i], 0.5 * timeStep);
-        }
-    } else if (integrationMethod == "dkd") {
-        for (Particle& particle : particles) {
-            particle.updatePosition(particle.velocity, 0.5 * timeStep);
+    for (const Particle<T>& particle : particles) {
+        for (const T value : {particle.mass, particle.position.x, particle.position.y,
+                              particle.velocity.x, particle.velocity.y}) {
+            stateBytes.append(reinterpret_cast<const char*>(&value), sizeof value);
         }
+    }
 
-        particleAccelerations = calculateAccelerations(
-            particles, timeStep, enableAdaptiveTimeStep, maxVelocityStep);
+    return getFnv1aHash(stateBytes);
+}
 
-        for (size_t i = 0; i < particles.size(); i++) {
-            particles[i].updateVelocity(particleAccelerations[i], timeStep);
-            particles[i].updatePosition(particles[i].velocity, 0.5 * timeStep);
-        }
-    } else if (integrationMethod == "euler") {
-        particleAccelerations = calculateAccelerations(
-            particles, timeStep, enableAdaptiveTimeStep, maxVelocityStep);
+template <typename T, typename F>
+std::filesystem::path ParticleSystem<T, F>::getOutputFilePath(
+    const std::filesystem::path& outputDirPath) const {
+    return outputDirPath / (inputFileStem + OUTPUT_FILE_SUFFIX);
+}
 
-        for (size_t i = 0; i < particles.size(); i++) {
-            particles[i].updatePosition(particles[i].velocity, timeStep);
-            particles[i].updateVelocity(particleAccelerations[i], timeStep);
-        }
-    } else if (integrationMethod == "rk4") {
-        std::vector<Particle> k1Particles = particles;
-        const std::vector<Vector2D> k1Accelerations
-            = calculateAccelerations(k1Particles, timeStep, false, maxVelocityStep);
-
-        std::vector<Particle> k2Particles = particles;
-        for (size_t i = 0; i < k2Particles.size(); i++) {
-            k2Particles[i].updatePosition(k1Particles[i].velocity, 0.5 * timeStep);
-            k2Particles[i].updateVelocity(k1Accelerations[i], 0.5 * timeStep);
-        }
-        const std::vector<Vector2D> k2Accelerations
-            = calculateAccelerations(k2Particles, timeStep, false, maxVelocityStep);
+template <typename T, typename F>
+void ParticleSystem<T, F>::initializeIntegration(const double fixedTimeStep,
+                                                 const bool enableAdaptiveTimeStep,
+                                                 const double maxVelocityStep,
+                                                 T* potentialEnergy) {
+    timeStep = fixedTimeStep;
+    currentTime = 0.0;
+    particleAccelerations = calculateAccelerations<T, F>(
+        particles, timeStep, enableAdaptiveTimeStep, maxVelocityStep, softeningLength,
+        potentialEnergy);
+
+    // A single remaining particle feels no force, which would leave the adaptive time
+    // step at the last (usually tiny) one
+    if (particles.size() == 1) timeStep = fixedTimeStep;
+}
 
-        std::vector<Particle> k3Particles = particles;
-        for (size_t i = 0; i < k3Particles.size(); i++) {
-            k3Particles[i].updatePosition(k2Particles[i].velocity, 0.5 * timeStep);
-            k3Particles[i].updateVelocity(k2Accelerations[i], 0.5 * timeStep);
+// Takes a single integration step and returns whether it produced the potential energy
+// of the new state (see integrate)
+template <typename T, typename F>
+bool ParticleSystem<T, F>::integrateStep(const std::string& integrationMethod,
+                                         const double fixedTimeStep,
+                                         const bool enableAdaptiveTimeStep,
+                                         const double maxVelocityStep,
+                                         T* potentialEnergy) {
+    const double previousTimeStep = timeStep;
+
+    const bool hasPotentialEnergy = integrate(
+        particleAccelerations, particles, timeStep, integrationMethod,
+        enableAdaptiveTimeStep, maxVelocityStep, softeningLength, potentialEnergy);
+
+    currentTime += timeStep;
+
+    stats.integratorSteps++;
+    if (timeStep != previousTimeStep) stats.adaptedSteps++;
+    if (timeStep < stats.minTimeStep) stats.minTimeStep = timeStep;
+    if (timeStep > stats.maxTimeStep) stats.maxTimeStep = timeStep;
+    if (liveStatus) liveStatus->addStep(currentTime, timeStep);
+
+    if (collisionRadius > 0.0) {
+        const std::vector<size_t> groupRoots
+            = findCollisionGroups(particles, collisionRadius);
+
+        if (!groupRoots.empty()) {
+            mergeParticles(groupRoots, fixedTimeStep, enableAdaptiveTimeStep,
+                           maxVelocityStep, potentialEnergy);
+
+            return potentialEnergy != nullptr;
         }
-        const std::vector<Vector2D> k3Accelerations
-            = calculateAccelerations(k3Particles, timeStep, false, maxVelocityStep);
+    }
 
-        std::vector<Particle> k4Particles = particles;
-        for (size_t i = 0; i < k4Particles.size(); i++) {
-            k4Particles[i].updatePosition(k3Particles[i].velocity, timeStep);
-            k4Particles[i].updateVelocity(k3Accelerations[i], timeStep);
-        }
-        const std::vector<Vector2D> k4Accelerations
-            = calculateAccelerations(k4Particles, timeStep, false, maxVelocityStep);
-
-        for (size_t i = 0; i < particles.size(); i++) {
-            particles[i].updatePosition(
-                (k1Particles[i].velocity + 2.0 * k2Particles[i].velocity
-                 + 2.0 * k3Particles[i].velocity + k4Particles[i].velocity)
-                    / 6.0,
-                timeStep);
-
-            particles[i].updateVelocity((k1Accelerations[i] + 2.0 * k2Accelerations[i]
-                                         + 2.0 * k3Accelerations[i]
-                                         + k4Accelerations[i])
-                                            / 6.0,
-                                        timeStep);
-        }
+    return hasPotentialEnergy;
+}
 
-        if (enableAdaptiveTimeStep)
-            calculateAccelerations(particles, timeStep, true, maxVelocityStep);
-    } else {
-        throw std::runtime_error("Unknown integration method: " + integrationMethod);
+// Replaces every group of colliding particles by a single one. The accelerations (and
+// the potential energy, if it is requested) are evaluated again for the new particles,
+// which also adapts the time step to them.
+template <typename T, typename F>
+void ParticleSystem<T, F>::mergeParticles(const std::vector<size_t>& groupRoots,
+                                          const double fixedTimeStep,
+                                          const bool enableAdaptiveTimeStep,
+                                          const double maxVelocityStep,
+                                          T* potentialEnergy) {
+    const double initialEnergy = getEnergy();
+    std::vector<int> mergedParticleIds;
+
+    for (size_t i = 0; i < particles.size(); i++) {
+        if (groupRoots[i] == i) mergedParticleIds.push_back(particleIds[i]);
     }
+
+    stats.mergedParticles += particles.size() - mergedParticleIds.size();
+    particles = mergeParticleGroups(particles, groupRoots);
+    particleIds = std::move(mergedParticleIds);
+    areParticleIdsWritten = false;
+    mergerEnergyChange += getEnergy() - initialEnergy;
+
+    particleAccelerations = calculateAccelerations<T, F>(
+        particles, timeStep, enableAdaptiveTimeStep, maxVelocityStep, softeningLength,
+        potentialEnergy);
+
+    // A single remaining particle feels no force, which would leave the adaptive time
+    // step at the last (usually tiny) one
+    if (particles.size() == 1) timeStep = fixedTimeStep;
 }
+
+template <typename T, typename F>
+void ParticleSystem<T, F>::recordState(std::ofstream& outputFile,
+                                       const double currentTime,
+                                       const T* potentialEnergy,
+                                       const double initialEnergy) {
+    const std::chrono::steady_clock::time_point startTime
+        = std::chrono::steady_clock::now();
+    size_t byteCount = 0;
+
+    if (liveStatus) liveStatus->isWriting.store(true, std::memory_order_relaxed);
+
+    if (!areParticleIdsWritten) {
+        stats.bytesWritten += writeParticleIds(outputFile, particleIds);
+        areParticleIdsWritten = true;
+    }
+
+    const double energy
+        = writeState(outputFile, currentTime, particles, softeningLength,
+                     potentialEnergy, &byteCount);
+    updateEnergyDrift(energy - mergerEnergyChange, initialEnergy);
+
+    if (liveStatus) liveStatus->isWriting.store(false, std::memory_order_relaxed);
+
+    stats.writtenStates++;
+    stats.bytesWritten += byteCount;
+    stats.writeSeconds += getSecondsSince(startTime);
+}
+
+template <typename T, typename F>
+void ParticleSystem<T, F>::updateEnergyDrift(const double energy,
+                                             const double initialEnergy) {
+    const double energyDrift = initialEnergy != 0.0
+        ? std::abs((energy - initialEnergy) / initialEnergy)
+        : std::abs(energy);
+
+    if (energyDrift > maxEnergyDrift) maxEnergyDrift = energyDrift;
+}
+
+template class ParticleSystem<double>;
+template class ParticleSystem<float>;
+template class ParticleSystem<double, float>;
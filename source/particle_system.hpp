@@ -1,16 +1,29 @@
 #pragma once
 
 #include "particle.hpp"
+#include "performance_report.hpp"
 #include "unit_system.hpp"
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <filesystem>
+#include <fstream>
+#include <span>
 
-class ParticleSystem {
+// T is the scalar type the particle state is stored and integrated in, F the one the
+// pairwise forces are evaluated in (double/double, float/float or mixed double/float)
+template <typename T, typename F = T> class ParticleSystem {
     public:
         ParticleSystem(const std::filesystem::path& inputFilePath,
                        const std::shared_ptr<const UnitSystem> simulationUnitSystem);
+        // Creates a system from caller-provided arrays of the particle masses and of
+        // their positions and velocities as interleaved (x, y) pairs, all given in the
+        // simulation unit system
+        ParticleSystem(const std::string& name, std::span<const double> masses,
+                       std::span<const double> positions,
+                       std::span<const double> velocities,
+                       const std::shared_ptr<const UnitSystem> simulationUnitSystem);
 
         void simulate(const double fixedTimeStep,
                       const std::filesystem::path& outputDirPath,
@@ -19,7 +32,90 @@ class ParticleSystem {
                       const double writeStatePeriod,
                       const std::string& integrationMethod);
 
+        // Advances the system by up to maxSteps integration steps (0 for no limit) or
+        // until its time exceeds maxTime without writing any states and returns the
+        // number of steps taken. The first call continues where the last simulation
+        // ended or starts at time 0 if there was none.
+        unsigned long step(const unsigned long maxSteps, const double maxTime,
+                           const double fixedTimeStep,
+                           const bool enableAdaptiveTimeStep,
+                           const double maxVelocityStep,
+                           const std::string& integrationMethod);
+
+        // Decreases when particles are merged (see setInteraction)
+        size_t getParticleCount() const;
+        double getCurrentTime() const;
+        double getTimeStep() const;
+        double getEnergy() const;
+
+        // Direct read-only access to the particle state
+        const std::vector<Particle<T>>& getParticles() const;
+
+        // Writes the positions and velocities as interleaved (x, y) pairs into
+        // caller-provided buffers of 2 * getParticleCount() values each (either of them
+        // may be empty)
+        void copyState(std::span<double> positions, std::span<double> velocities) const;
+
+        // Maximum relative deviation of the energy from its initial value over all
+        // written states of the last simulation
+        double getMaxEnergyDrift() const;
+
+        // Classification of the final state of the last simulation: -1 if it was
+        // stopped by maxIterations, otherwise the input index of the particle which is
+        // furthest away from its nearest neighbour (i.e. the ejected star of a 3-body
+        // system; merged particles have the index of their first particle)
+        int getOutcome() const;
+
+        // Counters and timers of parsing and all simulations of this system
+        const SimulationStats& getStats() const;
+
+        // Sets the Plummer softening length of the gravity (see Particle) and the
+        // distance below which particles collide and are merged (see
+        // findCollisionGroups) for all following simulations and steps (0 to disable
+        // either)
+        void setInteraction(const double softeningLength, const double collisionRadius);
+        // Publishes the progress of all following simulations and steps to liveStatus
+        // (nullptr to stop), which must outlive them
+        void setLiveStatus(LiveSystemStatus* liveStatus);
+
+        // Hash of the exact current particle state (see ResultCache)
+        uint64_t getStateHash() const;
+        std::filesystem::path
+        getOutputFilePath(const std::filesystem::path& outputDirPath) const;
+
     private:
-        std::vector<Particle> particles;
+        std::vector<Particle<T>> particles;
         const std::string inputFileStem;
+        double maxEnergyDrift = 0.0;
+        bool reachedMaxIterations = false;
+        SimulationStats stats;
+        LiveSystemStatus* liveStatus = nullptr;
+        double softeningLength = 0.0;
+        double collisionRadius = 0.0;
+        std::vector<int> particleIds; // input indices of the particles
+        // Whether the output file lists the particles after the last merger
+        bool areParticleIdsWritten = true;
+        // Change of the energy by the mergers of the last simulation, which does not
+        // count as energy drift
+        double mergerEnergyChange = 0.0;
+
+        // Integration state which is kept between simulate() and step() calls
+        std::vector<Vector2D<F>> particleAccelerations;
+        double timeStep = 0.0;
+        double currentTime = 0.0;
+
+        void initializeIntegration(const double fixedTimeStep,
+                                   const bool enableAdaptiveTimeStep,
+                                   const double maxVelocityStep, T* potentialEnergy);
+        bool integrateStep(const std::string& integrationMethod,
+                           const double fixedTimeStep,
+                           const bool enableAdaptiveTimeStep,
+                           const double maxVelocityStep, T* potentialEnergy);
+        void mergeParticles(const std::vector<size_t>& groupRoots,
+                            const double fixedTimeStep,
+                            const bool enableAdaptiveTimeStep,
+                            const double maxVelocityStep, T* potentialEnergy);
+        void recordState(std::ofstream& outputFile, const double currentTime,
+                         const T* potentialEnergy, const double initialEnergy);
+        void updateEnergyDrift(const double energy, const double initialEnergy);
 };
@@ -0,0 +1,169 @@
+#include "performance_report.hpp"
+
+#include "util.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+thread_local constinit ForceCounters threadForceCounters;
+
+static void writeStats(std::ostream& outputStream, const SimulationStats& stats,
+                       const std::string& indent);
+
+void SimulationStats::add(const SimulationStats& stats) {
+    systemCount += stats.systemCount;
+    cachedSystems += stats.cachedSystems;
+    forceEvaluations += stats.forceEvaluations;
+    pairInteractions += stats.pairInteractions;
+    forceSampledEvaluations += stats.forceSampledEvaluations;
+    forceSampledSeconds += stats.forceSampledSeconds;
+    integratorSteps += stats.integratorSteps;
+    adaptedSteps += stats.adaptedSteps;
+    minTimeStep = std::min(minTimeStep, stats.minTimeStep);
+    maxTimeStep = std::max(maxTimeStep, stats.maxTimeStep);
+    mergedParticles += stats.mergedParticles;
+    writtenStates += stats.writtenStates;
+    bytesWritten += stats.bytesWritten;
+    parseSeconds += stats.parseSeconds;
+    integrateSeconds += stats.integrateSeconds;
+    writeSeconds += stats.writeSeconds;
+    wallSeconds += stats.wallSeconds;
+}
+
+void SimulationStats::addForceCounters(const ForceCounters& before,
+                                       const ForceCounters& after) {
+    forceEvaluations += after.evaluations - before.evaluations;
+    pairInteractions += after.pairInteractions - before.pairInteractions;
+    forceSampledEvaluations += after.sampledEvaluations - before.sampledEvaluations;
+    forceSampledSeconds += after.sampledSeconds - before.sampledSeconds;
+}
+
+// Extrapolates the time of all force evaluations from the sampled ones
+double SimulationStats::getForceSeconds() const {
+    if (!forceSampledEvaluations) return 0.0;
+
+    return forceSampledSeconds / static_cast<double>(forceSampledEvaluations)
+        * static_cast<double>(forceEvaluations);
+}
+
+// Plain loads and stores instead of read-modify-write operations suffice, as there is
+// only one writer
+void LiveSystemStatus::addStep(const double currentTime, const double timeStep) {
+    if (isCountingTimeSteps) {
+        const int bucketIndex
+            = std::clamp(std::ilogb(timeStep), minTimeStepExponent,
+                         minTimeStepExponent + timeStepBucketCount - 1)
+            - minTimeStepExponent;
+        std::atomic<unsigned long>& timeStepCount = timeStepCounts[bucketIndex];
+
+        timeStepCount.store(timeStepCount.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+        timeStepSum.store(timeStepSum.load(std::memory_order_relaxed) + timeStep,
+                          std::memory_order_relaxed);
+    }
+
+    steps.store(steps.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    this->timeStep.store(timeStep, std::memory_order_relaxed);
+    this->currentTime.store(currentTime, std::memory_order_relaxed);
+}
+
+PerformanceReport::PerformanceReport(const int threadCount)
+    : threadTotals(threadCount)
+    , threadSystems(threadCount) {
+}
+
+void PerformanceReport::addSystem(const int threadIndex, const SimulationStats& stats) {
+    threadTotals[threadIndex].add(stats);
+    threadSystems[threadIndex].push_back(stats);
+}
+
+void PerformanceReport::write(const std::filesystem::path& filePath,
+                              const size_t slowestSystemCount) const {
+    SimulationStats totals;
+    std::vector<SimulationStats> slowestSystems;
+
+    for (size_t i = 0; i < threadTotals.size(); i++) {
+        totals.add(threadTotals[i]);
+        slowestSystems.insert(slowestSystems.end(), threadSystems[i].begin(),
+                              threadSystems[i].end());
+    }
+
+    const size_t slowestCount = std::min(slowestSystemCount, slowestSystems.size());
+
+    std::partial_sort(slowestSystems.begin(), slowestSystems.begin() + slowestCount,
+                      slowestSystems.end(),
+                      [](const SimulationStats& a, const SimulationStats& b) {
+                          return a.wallSeconds > b.wallSeconds;
+                      });
+    slowestSystems.resize(slowestCount);
+
+    std::ofstream reportFile = createOutputFile(filePath);
+
+    reportFile << "{\n    \"totals\": ";
+    writeStats(reportFile, totals, "    ");
+    reportFile << ",\n    \"threads\": [\n";
+
+    for (size_t i = 0; i < threadTotals.size(); i++) {
+        reportFile << "        ";
+        writeStats(reportFile, threadTotals[i], "        ");
+        reportFile << (i + 1 < threadTotals.size() ? ",\n" : "\n");
+    }
+
+    reportFile << "    ],\n    \"slowestSystems\": [\n";
+
+    for (size_t i = 0; i < slowestSystems.size(); i++) {
+        reportFile << "        ";
+        writeStats(reportFile, slowestSystems[i], "        ");
+        reportFile << (i + 1 < slowestSystems.size() ? ",\n" : "\n");
+    }
+
+    reportFile << "    ]\n}" << std::endl;
+}
+
+double getSecondsSince(const std::chrono::steady_clock::time_point& startTime) {
+    using namespace std::chrono;
+
+    return duration<double>(steady_clock::now() - startTime).count();
+}
+
+static void writeStats(std::ostream& outputStream, const SimulationStats& stats,
+                       const std::string& indent) {
+    const std::string fieldIndent = indent + "    ";
+
+    outputStream << "{\n";
+
+    if (!stats.name.empty())
+        outputStream << fieldIndent << "\"name\": \"" << escapeJsonString(stats.name)
+                     << "\",\n";
+
+    // The minimum time step is infinite if no steps were made, which is written as null
+    outputStream << fieldIndent << "\"systems\": " << stats.systemCount << ",\n"
+                 << fieldIndent << "\"cachedSystems\": " << stats.cachedSystems << ",\n"
+                 << fieldIndent << "\"forceEvaluations\": " << stats.forceEvaluations
+                 << ",\n"
+                 << fieldIndent << "\"pairInteractions\": " << stats.pairInteractions
+                 << ",\n"
+                 << fieldIndent << "\"integratorSteps\": " << stats.integratorSteps
+                 << ",\n"
+                 << fieldIndent << "\"adaptedSteps\": " << stats.adaptedSteps << ",\n"
+                 << fieldIndent << "\"minTimeStep\": "
+                 << getJsonNumber(stats.minTimeStep) << ",\n"
+                 << fieldIndent << "\"maxTimeStep\": "
+                 << getJsonNumber(stats.maxTimeStep) << ",\n"
+                 << fieldIndent << "\"mergedParticles\": " << stats.mergedParticles
+                 << ",\n"
+                 << fieldIndent << "\"writtenStates\": " << stats.writtenStates << ",\n"
+                 << fieldIndent << "\"bytesWritten\": " << stats.bytesWritten << ",\n"
+                 << fieldIndent << "\"parseSeconds\": "
+                 << getJsonNumber(stats.parseSeconds) << ",\n"
+                 << fieldIndent << "\"forceSeconds\": "
+                 << getJsonNumber(stats.getForceSeconds()) << ",\n"
+                 << fieldIndent << "\"integrateSeconds\": "
+                 << getJsonNumber(stats.integrateSeconds) << ",\n"
+                 << fieldIndent << "\"writeSeconds\": "
+                 << getJsonNumber(stats.writeSeconds) << ",\n"
+                 << fieldIndent << "\"wallSeconds\": "
+                 << getJsonNumber(stats.wallSeconds) << "\n"
+                 << indent << "}";
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Counters of the force kernel, kept per thread (see threadForceCounters). Only a
+// sample of the evaluations is timed, as reading the clock costs about as much as a
+// force evaluation of a 3-body system.
+class ForceCounters {
+    public:
+        unsigned long evaluations = 0;
+        unsigned long pairInteractions = 0;
+        unsigned long sampledEvaluations = 0;
+        double sampledSeconds = 0.0;
+};
+
+extern thread_local constinit ForceCounters threadForceCounters;
+
+// Counters and timers of a single simulated system (or the sum of several)
+class SimulationStats {
+    public:
+        std::string name;
+        unsigned long systemCount = 0;
+        unsigned long cachedSystems = 0; // restored from the result cache
+        unsigned long forceEvaluations = 0;
+        unsigned long pairInteractions = 0;
+        unsigned long forceSampledEvaluations = 0;
+        double forceSampledSeconds = 0.0;
+        unsigned long integratorSteps = 0;
+        unsigned long adaptedSteps = 0;
+        double minTimeStep = std::numeric_limits<double>::infinity();
+        double maxTimeStep = 0.0;
+        unsigned long mergedParticles = 0; // removed by mergers
+        unsigned long writtenStates = 0;
+        unsigned long bytesWritten = 0;
+        double parseSeconds = 0.0;
+        double integrateSeconds = 0.0;
+        double writeSeconds = 0.0;
+        double wallSeconds = 0.0;
+
+        void add(const SimulationStats& stats);
+        void addForceCounters(const ForceCounters& before, const ForceCounters& after);
+        double getForceSeconds() const;
+};
+
+// Live state of the system which a thread is simulating. Only that thread writes it
+// (with relaxed stores), so that ProgressReporter can sample it at almost no cost to
+// the simulation. Aligned to a cache line to avoid false sharing between threads.
+class alignas(64) LiveSystemStatus {
+    public:
+        // Time steps are counted in power-of-2 buckets: bucket i counts the steps in
+        // [2^(i + minTimeStepExponent), 2^(i + 1 + minTimeStepExponent)), the first and
+        // last buckets also everything below and above
+        static constexpr int minTimeStepExponent = -40;
+        static constexpr int timeStepBucketCount = 50;
+
+        std::atomic<size_t> systemIndex;
+        std::atomic<double> startSeconds;
+        std::atomic<double> currentTime;
+        std::atomic<double> maxTime;
+        std::atomic<double> timeStep;
+        std::atomic<unsigned long> steps;
+        std::atomic<bool> isWriting;
+        // Over all systems the thread simulated
+        std::array<std::atomic<unsigned long>, timeStepBucketCount> timeStepCounts;
+        std::atomic<double> timeStepSum;
+        // Whether addStep updates timeStepCounts and timeStepSum, which only the
+        // metrics need. Set before the simulation threads start.
+        bool isCountingTimeSteps = false;
+
+        // Must only be called by the owning thread
+        void addStep(const double currentTime, const double timeStep);
+};
+
+// Collects the stats of all simulated systems by thread and writes them as JSON
+class PerformanceReport {
+    public:
+        PerformanceReport(const int threadCount);
+
+        // Must only be called by the thread with the given index
+        void addSystem(const int threadIndex, const SimulationStats& stats);
+        void write(const std::filesystem::path& filePath,
+                   const size_t slowestSystemCount) const;
+
+    private:
+        std::vector<SimulationStats> threadTotals;
+        std::vector<std::vector<SimulationStats>> threadSystems;
+};
+
+double getSecondsSince(const std::chrono::steady_clock::time_point& startTime);
@@ -0,0 +1,291 @@
+#include "progress_reporter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <tuple>
+
+#define NO_SYSTEM std::numeric_limits<size_t>::max()
+#define LONGEST_RUNNING_SYSTEM_COUNT 3
+#define METRIC_PREFIX "gravity_"
+
+static std::string getDurationString(const double seconds);
+static void appendMetricHeader(std::string& metrics, const std::string& name,
+                               const std::string& type, const std::string& help);
+static std::string getLabelValue(const std::string& value);
+
+ProgressReporter::ProgressReporter(const std::vector<std::string>& systemNames,
+                                   const double interval, const int threadCount,
+                                   const bool hasMetrics)
+    : systemNames(systemNames)
+    , interval(interval)
+    , startTime(std::chrono::steady_clock::now())
+    , liveStatuses(threadCount) {
+    for (LiveSystemStatus& liveStatus : liveStatuses) {
+        liveStatus.systemIndex = NO_SYSTEM;
+        liveStatus.isCountingTimeSteps = hasMetrics;
+    }
+
+    if (interval > 0.0) reporterThread = std::thread(&ProgressReporter::run, this);
+}
+
+ProgressReporter::~ProgressReporter() {
+    if (!reporterThread.joinable()) return;
+
+    {
+        const std::lock_guard<std::mutex> lock(stopMutex);
+        isStopping = true;
+    }
+
+    stopCondition.notify_one();
+    reporterThread.join();
+}
+
+void ProgressReporter::startSystem(const int threadIndex, const size_t systemIndex) {
+    LiveSystemStatus& liveStatus = liveStatuses[threadIndex];
+
+    liveStatus.startSeconds.store(getSecondsSince(startTime),
+                                  std::memory_order_relaxed);
+    liveStatus.currentTime.store(0.0, std::memory_order_relaxed);
+    liveStatus.maxTime.store(0.0, std::memory_order_relaxed);
+    liveStatus.timeStep.store(0.0, std::memory_order_relaxed);
+    liveStatus.steps.store(0, std::memory_order_relaxed);
+    liveStatus.systemIndex.store(systemIndex, std::memory_order_release);
+}
+
+void ProgressReporter::finishSystem(const int threadIndex,
+                                    const SimulationStats& stats) {
+    liveStatuses[threadIndex].systemIndex.store(NO_SYSTEM, std::memory_order_relaxed);
+
+    completedSteps.fetch_add(stats.integratorSteps, std::memory_order_relaxed);
+    completedSeconds.fetch_add(stats.wallSeconds, std::memory_order_relaxed);
+    completedCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+LiveSystemStatus* ProgressReporter::getLiveStatus(const int threadIndex) {
+    return &liveStatuses[threadIndex];
+}
+
+std::string ProgressReporter::getMetrics(const size_t slowestSystemCount) const {
+    const double elapsedSeconds = getSecondsSince(startTime);
+    const std::vector<RunningSystem> runningSystems = getRunningSystems(elapsedSeconds);
+
+    unsigned long steps = completedSteps.load(std::memory_order_relaxed);
+    std::array<unsigned long, LiveSystemStatus::timeStepBucketCount> timeStepCounts {};
+    double timeStepSum = 0.0;
+    int writingCount = 0;
+
+    for (const RunningSystem& runningSystem : runningSystems) {
+        steps += runningSystem.steps;
+    }
+
+    for (const LiveSystemStatus& liveStatus : liveStatuses) {
+        for (int i = 0; i < LiveSystemStatus::timeStepBucketCount; i++) {
+            timeStepCounts[i]
+                += liveStatus.timeStepCounts[i].load(std::memory_order_relaxed);
+        }
+
+        timeStepSum += liveStatus.timeStepSum.load(std::memory_order_relaxed);
+        if (liveStatus.isWriting.load(std::memory_order_relaxed)) writingCount++;
+    }
+
+    std::string metrics;
+
+    appendMetricHeader(metrics, "elapsed_seconds", "gauge",
+                       "Seconds since the simulations started");
+    metrics += std::format(METRIC_PREFIX "elapsed_seconds {}\n", elapsedSeconds);
+    appendMetricHeader(metrics, "systems", "gauge", "Systems to simulate");
+    metrics += std::format(METRIC_PREFIX "systems {}\n", systemNames.size());
+    appendMetricHeader(metrics, "systems_completed_total", "counter",
+                       "Systems which were simulated or restored from the cache");
+    metrics += std::format(METRIC_PREFIX "systems_completed_total {}\n",
+                           completedCount.load(std::memory_order_relaxed));
+    appendMetricHeader(metrics, "systems_in_flight", "gauge",
+                       "Systems which are being simulated");
+    metrics += std::format(METRIC_PREFIX "systems_in_flight {}\n",
+                           runningSystems.size());
+    appendMetricHeader(metrics, "steps_total", "counter", "Integration steps taken");
+    metrics += std::format(METRIC_PREFIX "steps_total {}\n", steps);
+    appendMetricHeader(metrics, "steps_per_second", "gauge",
+                       "Integration steps per second since the simulations started");
+    metrics += std::format(METRIC_PREFIX "steps_per_second {}\n",
+                           static_cast<double>(steps) / elapsedSeconds);
+    appendMetricHeader(metrics, "writer_queue_depth", "gauge",
+                       "Threads which are writing a state (writes are synchronous)");
+    metrics += std::format(METRIC_PREFIX "writer_queue_depth {}\n", writingCount);
+
+    appendMetricHeader(metrics, "time_step", "histogram",
+                       "Time steps of all integration steps taken");
+
+    unsigned long cumulativeCount = 0;
+
+    // The last bucket also counts everything above it, so its bound is +Inf
+    for (int i = 0; i < LiveSystemStatus::timeStepBucketCount; i++) {
+        const int exponent = i + 1 + LiveSystemStatus::minTimeStepExponent;
+        const std::string bound = i + 1 < LiveSystemStatus::timeStepBucketCount
+            ? std::format("{}", std::ldexp(1.0, exponent))
+            : "+Inf";
+
+        cumulativeCount += timeStepCounts[i];
+        metrics += std::format(METRIC_PREFIX "time_step_bucket{{le=\"{}\"}} {}\n",
+                               bound, cumulativeCount);
+    }
+
+    metrics += std::format(METRIC_PREFIX "time_step_sum {}\n", timeStepSum);
+    metrics += std::format(METRIC_PREFIX "time_step_count {}\n", cumulativeCount);
+
+    const size_t slowestCount = std::min(slowestSystemCount, runningSystems.size());
+    const std::tuple<std::string, std::string, double RunningSystem::*>
+        slowestSystemMetrics[] = {
+            { "running_system_seconds",
+              "Seconds the longest running systems have been simulated for",
+              &RunningSystem::runningSeconds },
+            { "running_system_time", "Current time of the longest running systems",
+              &RunningSystem::currentTime },
+            { "running_system_max_time",
+              "Time the longest running systems are simulated until",
+              &RunningSystem::maxTime },
+            { "running_system_time_step",
+              "Current time step of the longest running systems",
+              &RunningSystem::timeStep }
+        };
+
+    for (const auto& [name, help, member] : slowestSystemMetrics) {
+        appendMetricHeader(metrics, name, "gauge", help);
+
+        for (size_t i = 0; i < slowestCount; i++) {
+            metrics += std::format(
+                METRIC_PREFIX "{}{{system=\"{}\"}} {}\n", name,
+                getLabelValue(systemNames[runningSystems[i].systemIndex]),
+                runningSystems[i].*member);
+        }
+    }
+
+    return metrics;
+}
+
+void ProgressReporter::run() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+
+    while (!stopCondition.wait_for(lock, std::chrono::duration<double>(interval),
+                                   [this]() { return isStopping; })) {
+        printProgress();
+    }
+
+    printProgress();
+}
+
+// The ETA assumes that every system which has not been completed yet costs as much as
+// the completed ones did on average (minus the time in-flight systems already ran)
+void ProgressReporter::printProgress() const {
+    const double elapsedSeconds = getSecondsSince(startTime);
+    const size_t totalCount = systemNames.size();
+
+    // e.g. for an empty shard
+    if (totalCount == 0) {
+        std::cout << "Progress: no systems to simulate" << std::endl;
+
+        return;
+    }
+
+    const size_t completed = completedCount.load(std::memory_order_relaxed);
+    const double meanSystemSeconds = completed
+        ? completedSeconds.load(std::memory_order_relaxed)
+            / static_cast<double>(completed)
+        : 0.0;
+    const std::vector<RunningSystem> runningSystems = getRunningSystems(elapsedSeconds);
+
+    unsigned long steps = completedSteps.load(std::memory_order_relaxed);
+    double remainingSeconds = 0.0;
+
+    for (const RunningSystem& runningSystem : runningSystems) {
+        steps += runningSystem.steps;
+        remainingSeconds
+            += std::max(meanSystemSeconds - runningSystem.runningSeconds, 0.0);
+    }
+
+    // The counters are read without synchronization, so they may not add up exactly
+    const size_t pendingCount = std::max(totalCount, completed + runningSystems.size())
+        - completed - runningSystems.size();
+    remainingSeconds += static_cast<double>(pendingCount) * meanSystemSeconds;
+
+    std::string line = std::format(
+        "Progress: {}/{} ({:.1f} %), {:.1f} systems/s, {:.3g} steps/s", completed,
+        totalCount,
+        static_cast<double>(completed) / static_cast<double>(totalCount) * 100.0,
+        static_cast<double>(completed) / elapsedSeconds,
+        static_cast<double>(steps) / elapsedSeconds);
+
+    if (completed && completed < totalCount) {
+        line += ", ETA: "
+            + getDurationString(remainingSeconds
+                                / static_cast<double>(liveStatuses.size()));
+    }
+
+    const size_t longestRunningCount
+        = std::min<size_t>(LONGEST_RUNNING_SYSTEM_COUNT, runningSystems.size());
+
+    for (size_t i = 0; i < longestRunningCount; i++) {
+        line += std::format("{} {} ({:.1f} s)", i == 0 ? ", longest running:" : ",",
+                            systemNames[runningSystems[i].systemIndex],
+                            runningSystems[i].runningSeconds);
+    }
+
+    std::cout << line << std::endl;
+}
+
+std::vector<ProgressReporter::RunningSystem>
+ProgressReporter::getRunningSystems(const double elapsedSeconds) const {
+    std::vector<RunningSystem> runningSystems;
+
+    for (const LiveSystemStatus& liveStatus : liveStatuses) {
+        const size_t systemIndex
+            = liveStatus.systemIndex.load(std::memory_order_acquire);
+
+        if (systemIndex == NO_SYSTEM) continue;
+
+        runningSystems.push_back(
+            { systemIndex,
+              elapsedSeconds - liveStatus.startSeconds.load(std::memory_order_relaxed),
+              liveStatus.currentTime.load(std::memory_order_relaxed),
+              liveStatus.maxTime.load(std::memory_order_relaxed),
+              liveStatus.timeStep.load(std::memory_order_relaxed),
+              liveStatus.steps.load(std::memory_order_relaxed) });
+    }
+
+    std::sort(runningSystems.begin(), runningSystems.end(),
+              [](const RunningSystem& a, const RunningSystem& b) {
+                  return a.runningSeconds > b.runningSeconds;
+              });
+
+    return runningSystems;
+}
+
+static std::string getDurationString(const double seconds) {
+    const long totalSeconds = static_cast<long>(seconds);
+
+    return std::format("{:02}:{:02}:{:02}", totalSeconds / 3600, totalSeconds / 60 % 60,
+                       totalSeconds % 60);
+}
+
+static void appendMetricHeader(std::string& metrics, const std::string& name,
+                               const std::string& type, const std::string& help) {
+    metrics += std::format("# HELP " METRIC_PREFIX "{} {}\n", name, help);
+    metrics += std::format("# TYPE " METRIC_PREFIX "{} {}\n", name, type);
+}
+
+// Escapes a label value of the Prometheus text format
+static std::string getLabelValue(const std::string& value) {
+    std::string labelValue;
+
+    for (const char character : value) {
+        if (character == '\\' || character == '"' || character == '\n')
+            labelValue += '\\';
+
+        labelValue += character == '\n' ? 'n' : character;
+    }
+
+    return labelValue;
+}
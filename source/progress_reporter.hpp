@@ -0,0 +1,63 @@
+#pragma once
+
+#include "performance_report.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Prints the progress of a set of simulations from a background thread every
+// interval seconds (never if interval is 0), so that the simulation threads only have
+// to update a few atomics per system and step. The time step counts for getMetrics are
+// only collected if hasMetrics is true.
+class ProgressReporter {
+    public:
+        ProgressReporter(const std::vector<std::string>& systemNames,
+                         const double interval, const int threadCount,
+                         const bool hasMetrics);
+        ~ProgressReporter();
+
+        // Must only be called by the thread with the given index
+        void startSystem(const int threadIndex, const size_t systemIndex);
+        void finishSystem(const int threadIndex, const SimulationStats& stats);
+        // Status for the system the thread with the given index is simulating (see
+        // ParticleSystem::setLiveStatus)
+        LiveSystemStatus* getLiveStatus(const int threadIndex);
+
+        // Snapshot of the progress in the Prometheus text format (see README)
+        std::string getMetrics(const size_t slowestSystemCount) const;
+
+    private:
+        const std::vector<std::string> systemNames;
+        const double interval;
+        const std::chrono::steady_clock::time_point startTime;
+        std::vector<LiveSystemStatus> liveStatuses;
+        std::atomic<size_t> completedCount = 0;
+        std::atomic<unsigned long> completedSteps = 0;
+        std::atomic<double> completedSeconds = 0.0;
+
+        std::mutex stopMutex;
+        std::condition_variable stopCondition;
+        bool isStopping = false;
+        std::thread reporterThread;
+
+        // Snapshot of a system which is being simulated
+        class RunningSystem {
+            public:
+                size_t systemIndex;
+                double runningSeconds;
+                double currentTime;
+                double maxTime;
+                double timeStep;
+                unsigned long steps;
+        };
+
+        void run();
+        void printProgress() const;
+        // Sorted by descending running time
+        std::vector<RunningSystem> getRunningSystems(const double elapsedSeconds) const;
+};
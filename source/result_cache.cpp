@@ -0,0 +1,111 @@
+#include "result_cache.hpp"
+
+#include "util.hpp"
+
+#include <format>
+#include <fstream>
+#include <random>
+#include <system_error>
+
+// Must be increased whenever a change of the simulation code changes its results, so
+// that entries of older versions are not used anymore
+#define RESULT_CACHE_VERSION 2
+#define RESULT_CACHE_OUTPUT_EXTENSION ".txt"
+#define RESULT_CACHE_OUTCOME_EXTENSION ".outcome"
+
+static void linkOrCopyFile(const std::filesystem::path& sourcePath,
+                           const std::filesystem::path& targetPath);
+static std::filesystem::path getTemporaryPath(const std::filesystem::path& filePath);
+
+// Floating point parameters are formatted in hexadecimal so that the fingerprint is
+// exact
+ResultCache::ResultCache(const std::filesystem::path& cacheDirPath,
+                         const Config& config, const std::string& precision)
+    : cacheDirPath(cacheDirPath)
+    , configFingerprint(std::format(
+          "{}|{}|{}|{}|{:a}|{}|{:a}|{:a}|{}|{:a}|{:a}|{:a}", RESULT_CACHE_VERSION,
+          config.unitSystem.id, precision, config.integrationMethod,
+          config.fixedTimeStep, config.enableAdaptiveTimeStep, config.maxVelocityStep,
+          config.maxTime, config.maxIterations, config.writeStatePeriod,
+          config.softeningLength, config.collisionRadius)) {
+    std::filesystem::create_directories(cacheDirPath);
+}
+
+uint64_t ResultCache::getKey(const uint64_t stateHash) const {
+    return getFnv1aHash(std::format("{:016x}|{}", stateHash, configFingerprint));
+}
+
+std::optional<int>
+ResultCache::restore(const uint64_t key,
+                     const std::filesystem::path& outputFilePath) const {
+    const std::filesystem::path cachedOutputPath
+        = getEntryPath(key, RESULT_CACHE_OUTPUT_EXTENSION);
+    std::ifstream outcomeFile(getEntryPath(key, RESULT_CACHE_OUTCOME_EXTENSION));
+    int outcome;
+
+    if (!(outcomeFile >> outcome) || !std::filesystem::exists(cachedOutputPath))
+        return std::nullopt;
+
+    // The output file may still be the link created by the last run
+    if (std::filesystem::exists(outputFilePath)
+        && std::filesystem::equivalent(outputFilePath, cachedOutputPath))
+        return outcome;
+
+    std::filesystem::create_directories(outputFilePath.parent_path());
+    std::filesystem::remove(outputFilePath);
+    linkOrCopyFile(cachedOutputPath, outputFilePath);
+
+    return outcome;
+}
+
+void ResultCache::store(const uint64_t key, const std::filesystem::path& outputFilePath,
+                        const int outcome) const {
+    const std::filesystem::path cachedOutputPath
+        = getEntryPath(key, RESULT_CACHE_OUTPUT_EXTENSION);
+    const std::filesystem::path outcomePath
+        = getEntryPath(key, RESULT_CACHE_OUTCOME_EXTENSION);
+
+    if (!std::filesystem::exists(cachedOutputPath))
+        linkOrCopyFile(outputFilePath, cachedOutputPath);
+
+    // The outcome file marks the entry as complete, so it is written under a unique
+    // temporary name and then renamed, which is atomic
+    const std::filesystem::path temporaryPath = getTemporaryPath(outcomePath);
+
+    {
+        std::ofstream outcomeFile = createOutputFile(temporaryPath);
+        outcomeFile << outcome << std::endl;
+    }
+
+    std::filesystem::rename(temporaryPath, outcomePath);
+}
+
+std::filesystem::path ResultCache::getEntryPath(const uint64_t key,
+                                                const std::string& extension) const {
+    return cacheDirPath / std::format("{:016x}{}", key, extension);
+}
+
+// Hard links can fail, e.g. across file systems, in which case the file is copied. The
+// copy is made under a temporary name and renamed, so that concurrent processes never
+// see a partially written file at targetPath.
+static void linkOrCopyFile(const std::filesystem::path& sourcePath,
+                           const std::filesystem::path& targetPath) {
+    std::error_code errorCode;
+
+    std::filesystem::create_hard_link(sourcePath, targetPath, errorCode);
+
+    // Another process has already added the file
+    if (!errorCode || errorCode == std::errc::file_exists) return;
+
+    const std::filesystem::path temporaryPath = getTemporaryPath(targetPath);
+
+    std::filesystem::copy_file(sourcePath, temporaryPath);
+    std::filesystem::rename(temporaryPath, targetPath);
+}
+
+// Unique name in the directory of filePath
+static std::filesystem::path getTemporaryPath(const std::filesystem::path& filePath) {
+    thread_local std::mt19937_64 randomEngine(std::random_device{}());
+
+    return std::format("{}.{:016x}", filePath.string(), randomEngine());
+}
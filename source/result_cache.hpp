@@ -0,0 +1,36 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+// Directory of previous output files keyed by a hash of the initial particle state and
+// all config parameters which affect the result (unit system, precision, integration
+// method, time step settings, maxTime, maxIterations, writeStatePeriod, softening
+// length and collision radius). Entries are hard links to the output files where
+// possible, so storing and restoring them does not copy any data.
+class ResultCache {
+    public:
+        ResultCache(const std::filesystem::path& cacheDirPath, const Config& config,
+                    const std::string& precision);
+
+        uint64_t getKey(const uint64_t stateHash) const;
+        // Links (or copies) the cached output file of key to outputFilePath and returns
+        // the cached outcome, or returns std::nullopt if there is no such entry
+        std::optional<int> restore(const uint64_t key,
+                                   const std::filesystem::path& outputFilePath) const;
+        // Adds outputFilePath and the outcome of its system as the entry of key. May be
+        // called concurrently, also by separate processes sharing the cache directory.
+        void store(const uint64_t key, const std::filesystem::path& outputFilePath,
+                   const int outcome) const;
+
+    private:
+        const std::filesystem::path cacheDirPath;
+        const std::string configFingerprint;
+
+        std::filesystem::path getEntryPath(const uint64_t key,
+                                           const std::string& extension) const;
+};
@@ -0,0 +1,269 @@
+#include "shard.hpp"
+
+#include "error_dict.hpp"
+#include "util.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#define SHARD_NAME_PREFIX "shard-"
+#define MERGE_MAX_PRINTED_PROBLEMS 20
+
+// A system as listed in a shard manifest
+class ManifestSystem {
+    public:
+        unsigned long shardIndex;
+        int outcome;
+        unsigned long integratorSteps;
+        double wallSeconds;
+};
+
+static void writeManifestSystem(std::ostream& outputStream, const std::string& name,
+                                const int outcome, const unsigned long integratorSteps,
+                                const double wallSeconds);
+
+Shard::Shard(const std::string& mode, const unsigned long index,
+             const unsigned long count)
+    : mode(mode)
+    , index(index)
+    , count(count) {
+    if (mode != "range" && mode != "hash")
+        throw std::invalid_argument(std::format("Unknown shard mode: '{}'", mode));
+
+    if (count == 0 || index >= count)
+        throw std::invalid_argument(
+            std::format("Invalid shard: index {} of {} shards", index, count));
+}
+
+std::vector<std::filesystem::directory_entry> Shard::selectFileEntries(
+    const std::vector<std::filesystem::directory_entry>& inputFileEntries) const {
+    const size_t inputFileCount = inputFileEntries.size();
+    std::vector<std::filesystem::directory_entry> shardFileEntries;
+
+    if (mode == "range") {
+        const size_t begin = inputFileCount * index / count;
+        const size_t end = inputFileCount * (index + 1) / count;
+
+        shardFileEntries.assign(inputFileEntries.begin() + begin,
+                                inputFileEntries.begin() + end);
+    } else {
+        for (const auto& fileEntry : inputFileEntries) {
+            if (getFnv1aHash(fileEntry.path().filename().string()) % count == index)
+                shardFileEntries.push_back(fileEntry);
+        }
+    }
+
+    return shardFileEntries;
+}
+
+std::string Shard::getName() const {
+    return std::format(SHARD_NAME_PREFIX "{}-of-{}", index, count);
+}
+
+ShardManifest::ShardManifest(const Shard& shard, const size_t inputFileCount,
+                             const size_t shardFileCount)
+    : shard(shard)
+    , inputFileCount(inputFileCount)
+    , outcomes(shardFileCount)
+    , systemStats(shardFileCount) {
+}
+
+void ShardManifest::addSystem(const size_t systemIndex, const int outcome,
+                              const SimulationStats& stats) {
+    outcomes[systemIndex] = outcome;
+    systemStats[systemIndex] = stats;
+}
+
+void ShardManifest::write(const std::filesystem::path& filePath) const {
+    std::vector<size_t> completedIndices;
+    double wallSeconds = 0.0;
+
+    for (size_t i = 0; i < systemStats.size(); i++) {
+        if (!systemStats[i].systemCount) continue;
+
+        completedIndices.push_back(i);
+        wallSeconds += systemStats[i].wallSeconds;
+    }
+
+    std::ofstream manifestFile = createOutputFile(filePath);
+
+    manifestFile << "{\n"
+                 << "    \"shardMode\": \"" << shard.mode << "\",\n"
+                 << "    \"shardIndex\": " << shard.index << ",\n"
+                 << "    \"shardCount\": " << shard.count << ",\n"
+                 << "    \"inputFileCount\": " << inputFileCount << ",\n"
+                 << "    \"shardFileCount\": " << systemStats.size() << ",\n"
+                 << "    \"completedCount\": " << completedIndices.size() << ",\n"
+                 << "    \"wallSeconds\": " << wallSeconds << ",\n"
+                 << "    \"systems\": [\n";
+
+    for (size_t i = 0; i < completedIndices.size(); i++) {
+        const size_t systemIndex = completedIndices[i];
+        const SimulationStats& stats = systemStats[systemIndex];
+
+        manifestFile << "        ";
+        writeManifestSystem(manifestFile, stats.name, outcomes[systemIndex],
+                            stats.integratorSteps, stats.wallSeconds);
+        manifestFile << (i + 1 < completedIndices.size() ? ",\n" : "\n");
+    }
+
+    manifestFile << "    ]\n}" << std::endl;
+}
+
+bool mergeShardManifests(
+    const std::filesystem::path& manifestDirPath,
+    const std::vector<std::filesystem::directory_entry>& inputFileEntries,
+    const std::filesystem::path& indexPath) {
+    const std::regex headerRegex(R"re(^    "(\w+)": "?([^",]*)"?,$)re");
+    const std::regex systemRegex(
+        R"re(\{"name": "((?:[^"\\]|\\.)*)", )re"
+        R"re("outcome": (-?\d+), "integratorSteps": (\d+), )re"
+        R"re("wallSeconds": ([^}]+)\})re");
+
+    std::string shardMode;
+    unsigned long shardCount = 0;
+    std::set<unsigned long> shardIndices;
+    std::map<std::string, std::vector<ManifestSystem>> systemsByName;
+    std::vector<std::string> problems;
+
+    for (const auto& fileEntry : getFileEntries(manifestDirPath)) {
+        const std::string fileName = fileEntry.path().filename().string();
+
+        if (!fileName.starts_with(SHARD_NAME_PREFIX)) continue;
+
+        std::ifstream manifestFile = loadTextFile(fileEntry.path());
+        ErrorDict<std::string> header(fileName);
+        std::string line;
+        std::smatch match;
+
+        while (std::getline(manifestFile, line)) {
+            if (std::regex_search(line, match, systemRegex)) {
+                systemsByName[unescapeJsonString(match[1].str())].push_back(
+                    ManifestSystem{std::stoul(header.at("shardIndex")),
+                                   std::stoi(match[2].str()),
+                                   std::stoul(match[3].str()),
+                                   std::stod(match[4].str())});
+            } else if (std::regex_search(line, match, headerRegex)) {
+                header[match[1].str()] = match[2].str();
+            }
+        }
+
+        const unsigned long manifestShardCount = std::stoul(header.at("shardCount"));
+        const unsigned long manifestShardIndex = std::stoul(header.at("shardIndex"));
+
+        if (shardMode.empty()) {
+            shardMode = header.at("shardMode");
+            shardCount = manifestShardCount;
+        }
+
+        if (header.at("shardMode") != shardMode || manifestShardCount != shardCount)
+            problems.push_back(
+                std::format("Manifest '{}' is from a different sharding ({} with {} "
+                            "shards instead of {} with {})",
+                            fileName, header.at("shardMode"), manifestShardCount,
+                            shardMode, shardCount));
+
+        if (std::stoul(header.at("inputFileCount")) != inputFileEntries.size())
+            problems.push_back(
+                std::format("Manifest '{}' is from {} input files instead of {}",
+                            fileName, header.at("inputFileCount"),
+                            inputFileEntries.size()));
+
+        if (!shardIndices.insert(manifestShardIndex).second)
+            problems.push_back(
+                std::format("Shard {} has more than one manifest", manifestShardIndex));
+    }
+
+    for (unsigned long i = 0; i < shardCount; i++) {
+        if (!shardIndices.contains(i))
+            problems.push_back(std::format("Manifest of shard {} is missing", i));
+    }
+
+    std::ofstream indexFile = createOutputFile(indexPath);
+    std::vector<std::string> indexLines;
+    std::set<std::string> inputNames;
+
+    for (const auto& fileEntry : inputFileEntries) {
+        const std::string name = fileEntry.path().stem().string();
+        const auto systemsIterator = systemsByName.find(name);
+        const size_t systemCount = systemsIterator != systemsByName.end()
+            ? systemsIterator->second.size()
+            : 0;
+
+        inputNames.insert(name);
+
+        if (systemCount == 0) {
+            problems.push_back(std::format("System '{}' is missing", name));
+            continue;
+        } else if (systemCount > 1) {
+            problems.push_back(
+                std::format("System '{}' was simulated {} times", name, systemCount));
+        }
+
+        const ManifestSystem& system = systemsIterator->second.front();
+        std::ostringstream lineStream;
+
+        lineStream << "{\"name\": \"" << escapeJsonString(name)
+                   << "\", \"shard\": " << system.shardIndex
+                   << ", \"outcome\": " << system.outcome
+                   << ", \"integratorSteps\": " << system.integratorSteps
+                   << ", \"wallSeconds\": " << system.wallSeconds << "}";
+        indexLines.push_back(lineStream.str());
+    }
+
+    for (const auto& [name, systems] : systemsByName) {
+        if (!inputNames.contains(name))
+            problems.push_back(std::format("System '{}' is not an input file", name));
+    }
+
+    const bool isComplete = problems.empty();
+
+    indexFile << "{\n"
+              << "    \"shardMode\": \"" << shardMode << "\",\n"
+              << "    \"shardCount\": " << shardCount << ",\n"
+              << "    \"inputFileCount\": " << inputFileEntries.size() << ",\n"
+              << "    \"completedCount\": " << indexLines.size() << ",\n"
+              << "    \"complete\": " << (isComplete ? "true" : "false") << ",\n"
+              << "    \"systems\": [\n";
+
+    for (size_t i = 0; i < indexLines.size(); i++) {
+        indexFile << "        " << indexLines[i]
+                  << (i + 1 < indexLines.size() ? ",\n" : "\n");
+    }
+
+    indexFile << "    ]\n}" << std::endl;
+
+    std::cout << "Merged " << shardIndices.size() << "/" << shardCount
+              << " shard manifests covering " << indexLines.size() << "/"
+              << inputFileEntries.size() << " systems into: " << indexPath
+              << std::endl;
+
+    const size_t printedProblemCount
+        = std::min<size_t>(problems.size(), MERGE_MAX_PRINTED_PROBLEMS);
+
+    for (size_t i = 0; i < printedProblemCount; i++) {
+        std::cout << "    " << problems[i] << std::endl;
+    }
+
+    if (problems.size() > MERGE_MAX_PRINTED_PROBLEMS)
+        std::cout << "    ... and " << problems.size() - MERGE_MAX_PRINTED_PROBLEMS
+                  << " more problems" << std::endl;
+
+    return isComplete;
+}
+
+static void writeManifestSystem(std::ostream& outputStream, const std::string& name,
+                                const int outcome, const unsigned long integratorSteps,
+                                const double wallSeconds) {
+    outputStream << "{\"name\": \"" << escapeJsonString(name)
+                 << "\", \"outcome\": " << outcome
+                 << ", \"integratorSteps\": " << integratorSteps
+                 << ", \"wallSeconds\": " << wallSeconds << "}";
+}
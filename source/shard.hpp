@@ -0,0 +1,55 @@
+#pragma once
+
+#include "performance_report.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Deterministic subset of the input files which is simulated by one of several
+// independent processes. With mode "range" every shard gets a contiguous block of the
+// (sorted) input files, with mode "hash" the files are assigned by a hash of their
+// name, which keeps the assignment of existing files when files are added or removed.
+class Shard {
+    public:
+        const std::string mode;
+        const unsigned long index;
+        const unsigned long count;
+
+        Shard(const std::string& mode, const unsigned long index,
+              const unsigned long count);
+
+        // Returns the input files of this shard in their original order
+        std::vector<std::filesystem::directory_entry>
+        selectFileEntries(const std::vector<std::filesystem::directory_entry>&
+                              inputFileEntries) const;
+        // e.g. "shard-0-of-4"
+        std::string getName() const;
+};
+
+// Completed systems of a shard with their outcome and timing, written as JSON with one
+// system per line so that mergeShardManifests() does not need a full JSON parser
+class ShardManifest {
+    public:
+        ShardManifest(const Shard& shard, const size_t inputFileCount,
+                      const size_t shardFileCount);
+
+        // May be called concurrently as long as every system index is only added once
+        void addSystem(const size_t systemIndex, const int outcome,
+                       const SimulationStats& stats);
+        void write(const std::filesystem::path& filePath) const;
+
+    private:
+        const Shard shard;
+        const size_t inputFileCount;
+        std::vector<int> outcomes;
+        std::vector<SimulationStats> systemStats; // systemCount is 0 until added
+};
+
+// Reads all shard manifests in manifestDirPath, checks that together they cover every
+// input file exactly once and writes a combined index of all systems (in input file
+// order) to indexPath. Returns false after printing the problems if they do not.
+bool mergeShardManifests(
+    const std::filesystem::path& manifestDirPath,
+    const std::vector<std::filesystem::directory_entry>& inputFileEntries,
+    const std::filesystem::path& indexPath);
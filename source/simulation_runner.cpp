@@ -0,0 +1,217 @@
+#include "simulation_runner.hpp"
+
+#include "metrics_server.hpp"
+#include "particle_system.hpp"
+#include "progress_reporter.hpp"
+#include "result_cache.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <optional>
+
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#define PRECISION_VALIDATION_DIR_NAME "precision-validation"
+
+template <typename T, typename F>
+static std::vector<int>
+simulateSystems(const Config& config,
+                const std::vector<std::filesystem::directory_entry>& inputFileEntries,
+                const std::filesystem::path& outputDirPath,
+                PerformanceReport* performanceReport, ShardManifest* shardManifest,
+                const ThreadPlacement* threadPlacement,
+                const ResultCache* resultCache);
+static int getThreadIndex();
+
+// Implementation of simulateSystems for state scalar type T and force scalar type F
+template <typename T, typename F>
+static std::vector<int>
+simulateSystems(const Config& config,
+                const std::vector<std::filesystem::directory_entry>& inputFileEntries,
+                const std::filesystem::path& outputDirPath,
+                PerformanceReport* performanceReport, ShardManifest* shardManifest,
+                const ThreadPlacement* threadPlacement,
+                const ResultCache* resultCache) {
+    const size_t inputFileCount = inputFileEntries.size();
+    std::vector<int> outcomes(inputFileCount);
+    std::vector<std::string> systemNames;
+    size_t cachedCount = 0;
+    int pinFailureCount = 0;
+
+    for (const auto& fileEntry : inputFileEntries) {
+        systemNames.push_back(fileEntry.path().stem().string());
+    }
+
+    ProgressReporter progressReporter(systemNames, config.progressInterval,
+                                      getThreadCount(), config.enableMetricsSocket);
+    // Declared after progressReporter, so that it stops serving before that is gone
+    std::optional<MetricsServer> metricsServer;
+
+    if (config.enableMetricsSocket)
+        metricsServer.emplace(config.metricsSocketPath, progressReporter);
+
+#ifdef _OPENMP
+    #pragma omp parallel reduction(+ : pinFailureCount)
+#endif
+    {
+        if (threadPlacement && !threadPlacement->pinThread(getThreadIndex()))
+            pinFailureCount++;
+
+        // Every thread shares its own copy of the unit system between its particles.
+        // With a single copy, every particle copy (e.g. in rk4) would update the same
+        // reference count from all threads, and the copy would live on one NUMA node.
+        const std::shared_ptr<const UnitSystem> threadUnitSystem
+            = std::make_shared<const UnitSystem>(config.unitSystem);
+
+        // Systems are constructed inside the loop, so that their state, integration
+        // workspace and output buffers are first touched by the simulating thread
+#ifdef _OPENMP
+    #pragma omp for reduction(+ : cachedCount)
+#endif
+        for (size_t i = 0; i < inputFileCount; i++) {
+            progressReporter.startSystem(getThreadIndex(), i);
+
+            ParticleSystem<T, F> particleSystem(inputFileEntries[i].path(),
+                                                threadUnitSystem);
+            particleSystem.setInteraction(config.softeningLength,
+                                          config.collisionRadius);
+            particleSystem.setLiveStatus(
+                progressReporter.getLiveStatus(getThreadIndex()));
+
+            const std::filesystem::path outputFilePath
+                = particleSystem.getOutputFilePath(outputDirPath);
+            const uint64_t cacheKey = resultCache
+                ? resultCache->getKey(particleSystem.getStateHash())
+                : 0;
+            const std::optional<int> cachedOutcome = resultCache
+                ? resultCache->restore(cacheKey, outputFilePath)
+                : std::nullopt;
+
+            if (cachedOutcome) {
+                outcomes[i] = *cachedOutcome;
+                cachedCount++;
+            } else {
+                particleSystem.simulate(config.fixedTimeStep, outputDirPath,
+                                        config.enableAdaptiveTimeStep,
+                                        config.maxVelocityStep, config.maxTime,
+                                        config.maxIterations, config.writeStatePeriod,
+                                        config.integrationMethod);
+
+                outcomes[i] = particleSystem.getOutcome();
+
+                if (resultCache)
+                    resultCache->store(cacheKey, outputFilePath, outcomes[i]);
+            }
+
+            SimulationStats stats = particleSystem.getStats();
+            stats.cachedSystems = cachedOutcome ? 1 : 0;
+
+            if (performanceReport)
+                performanceReport->addSystem(getThreadIndex(), stats);
+            if (shardManifest) shardManifest->addSystem(i, outcomes[i], stats);
+
+            progressReporter.finishSystem(getThreadIndex(), stats);
+        }
+    }
+
+    // The calling thread was pinned as OpenMP thread 0. Everything it starts later
+    // (e.g. the threads of the precision validation) would otherwise inherit its CPU.
+    if (threadPlacement) threadPlacement->unpinThread();
+
+    if (pinFailureCount)
+        std::cout << "Could not pin " << pinFailureCount << " threads to their CPUs"
+                  << std::endl;
+
+    if (resultCache)
+        std::cout << "Restored " << cachedCount << "/" << inputFileCount
+                  << " systems from the result cache" << std::endl;
+
+    return outcomes;
+}
+
+std::vector<int>
+simulateSystems(const Config& config, const std::string& precision,
+                const std::vector<std::filesystem::directory_entry>& inputFileEntries,
+                const std::filesystem::path& outputDirPath,
+                PerformanceReport* performanceReport, ShardManifest* shardManifest,
+                const ThreadPlacement* threadPlacement) {
+    std::optional<ResultCache> resultCache;
+
+    if (config.enableResultCache)
+        resultCache.emplace(config.resultCacheDirPath, config, precision);
+
+    const ResultCache* resultCachePointer = resultCache ? &*resultCache : nullptr;
+
+    if (precision == "double")
+        return simulateSystems<double, double>(
+            config, inputFileEntries, outputDirPath, performanceReport, shardManifest,
+            threadPlacement, resultCachePointer);
+    else if (precision == "float")
+        return simulateSystems<float, float>(config, inputFileEntries, outputDirPath,
+                                             performanceReport, shardManifest,
+                                             threadPlacement, resultCachePointer);
+    else if (precision == "mixed")
+        return simulateSystems<double, float>(config, inputFileEntries, outputDirPath,
+                                              performanceReport, shardManifest,
+                                              threadPlacement, resultCachePointer);
+    else
+        throw std::runtime_error("Unknown precision: " + precision);
+}
+
+int getThreadCount() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+static int getThreadIndex() {
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+void validatePrecision(
+    const Config& config,
+    const std::vector<std::filesystem::directory_entry>& inputFileEntries,
+    const std::vector<int>& outcomes) {
+    const size_t inputFileCount = inputFileEntries.size();
+    const size_t sampleStride = std::max<size_t>(
+        1, inputFileCount / config.precisionValidationSamples);
+
+    std::vector<std::filesystem::directory_entry> sampleFileEntries;
+    std::vector<int> sampleOutcomes;
+
+    for (size_t i = 0; i < inputFileCount
+         && sampleFileEntries.size() < config.precisionValidationSamples;
+         i += sampleStride) {
+        sampleFileEntries.push_back(inputFileEntries[i]);
+        sampleOutcomes.push_back(outcomes[i]);
+    }
+
+    std::cout << "\nValidating precision '" << config.precision << "' on "
+              << sampleFileEntries.size() << " systems\n" << std::endl;
+
+    const std::vector<int> referenceOutcomes
+        = simulateSystems(config, "double", sampleFileEntries,
+                          config.outputDirPath / PRECISION_VALIDATION_DIR_NAME,
+                          nullptr, nullptr, nullptr);
+
+    size_t mismatchCount = 0;
+
+    for (size_t i = 0; i < sampleOutcomes.size(); i++) {
+        if (sampleOutcomes[i] != referenceOutcomes[i]) mismatchCount++;
+    }
+
+    std::cout << "\nOutcome differs from double precision in " << mismatchCount << "/"
+              << sampleOutcomes.size() << " sampled systems ("
+              << static_cast<double>(mismatchCount)
+            / static_cast<double>(sampleOutcomes.size()) * 100.0
+              << " %)" << std::endl;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "config.hpp"
+#include "performance_report.hpp"
+#include "numa_topology.hpp"
+#include "shard.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Simulates all systems in parallel with the given precision (double, float or mixed)
+// and returns their outcomes (see ParticleSystem::getOutcome). If performanceReport or
+// shardManifest is not nullptr, every system is added to it. If threadPlacement is not
+// nullptr, the worker threads are pinned accordingly.
+std::vector<int>
+simulateSystems(const Config& config, const std::string& precision,
+                const std::vector<std::filesystem::directory_entry>& inputFileEntries,
+                const std::filesystem::path& outputDirPath,
+                PerformanceReport* performanceReport, ShardManifest* shardManifest,
+                const ThreadPlacement* threadPlacement);
+// Re-simulates an evenly spaced sample of the systems with double precision and reports
+// how often their outcome differs from the one obtained with the configured precision
+void validatePrecision(
+    const Config& config,
+    const std::vector<std::filesystem::directory_entry>& inputFileEntries,
+    const std::vector<int>& outcomes);
+int getThreadCount();
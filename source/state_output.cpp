@@ -0,0 +1,89 @@
+#include "state_output.hpp"
+
+#include "integration.hpp"
+
+#include <sstream>
+#include <string>
+
+// Starts a comment line, which e.g. numpy.loadtxt() skips
+#define PARTICLE_IDS_PREFIX "# particles: "
+
+template <typename T>
+static std::string getMassPosVelString(const std::vector<Particle<T>>& particles);
+
+// Writes the current state and returns its total energy. The potential energy is only
+// recalculated if it is not passed in from a previous force pass. The size of the line
+// is stored in byteCount (if it is not nullptr), as asking the stream for its position
+// would cost a system call.
+template <typename T>
+T writeState(std::ostream& outputStream, const double currentTime,
+             const std::vector<Particle<T>>& particles, const double softeningLength,
+             const T* potentialEnergy, size_t* byteCount) {
+    const T energy = (potentialEnergy ? *potentialEnergy
+                                      : getPotentialEnergy(particles, softeningLength))
+        + getKineticEnergy(particles);
+    std::stringstream lineStream;
+
+    lineStream << currentTime << ", " << getMassPosVelString(particles) << ", "
+               << energy << '\n';
+
+    const std::string line = lineStream.str();
+
+    outputStream << line << std::flush;
+
+    if (byteCount) *byteCount = line.size();
+
+    return energy;
+}
+
+size_t writeParticleIds(std::ostream& outputStream,
+                        const std::vector<int>& particleIds) {
+    std::stringstream lineStream;
+
+    lineStream << PARTICLE_IDS_PREFIX;
+
+    for (size_t i = 0; i < particleIds.size(); i++) {
+        if (i > 0) lineStream << ", ";
+
+        lineStream << particleIds[i];
+    }
+
+    lineStream << '\n';
+
+    const std::string line = lineStream.str();
+
+    outputStream << line;
+
+    return line.size();
+}
+
+template <typename T>
+static std::string getMassPosVelString(const std::vector<Particle<T>>& particles) {
+    const size_t particleCount = particles.size();
+    std::stringstream massPosVelStream;
+
+    for (const Particle<T>& particle : particles) {
+        massPosVelStream << particle.mass << ", ";
+    }
+
+    for (const Particle<T>& particle : particles) {
+        massPosVelStream << particle.position << ", ";
+    }
+
+    for (size_t i = 0; i < particleCount - 1; i++) {
+        massPosVelStream << particles[i].velocity << ", ";
+    }
+
+    massPosVelStream << particles[particleCount - 1].velocity;
+
+    return massPosVelStream.str();
+}
+
+template double writeState(std::ostream& outputStream, const double currentTime,
+                           const std::vector<Particle<double>>& particles,
+                           const double softeningLength,
+                           const double* potentialEnergy, size_t* byteCount);
+template float writeState(std::ostream& outputStream, const double currentTime,
+                          const std::vector<Particle<float>>& particles,
+                          const double softeningLength, const float* potentialEnergy,
+                          size_t* byteCount);
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "particle.hpp"
+
+#include <ostream>
+#include <vector>
+
+template <typename T>
+T writeState(std::ostream& outputStream, const double currentTime,
+             const std::vector<Particle<T>>& particles, const double softeningLength,
+             const T* potentialEnergy, size_t* byteCount = nullptr);
+// Writes a comment line with the input indices of the particles in the following states
+// and returns its number of bytes
+size_t writeParticleIds(std::ostream& outputStream,
+                        const std::vector<int>& particleIds);
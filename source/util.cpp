@@ -1,6 +1,8 @@
 #include "util.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <format>
 #include <sstream>
 #include <iostream>
@@ -71,18 +73,18 @@ getFileEntries(const std::filesystem::path& dirPath) {
         if (dirEntry.is_regular_file()) fileEntries.push_back(dirEntry);
     }
 
-    return fileEntries;
-}
+    std::sort(fileEntries.begin(), fileEntries.end());
 
-void printProgress(const size_t progress, const size_t total) {
-    std::cout << "Progress: " << progress << "/" << total << " ("
-              << static_cast<double>(progress) / static_cast<double>(total) * 100.0
-              << " %)" << std::endl;
+    return fileEntries;
 }
 
 std::ofstream createOutputFile(const std::filesystem::path& outputFilePath) {
     std::filesystem::create_directories(outputFilePath.parent_path());
 
+    // Replace instead of overwriting the file, as it may be a hard link into the result
+    // cache (see ResultCache)
+    std::filesystem::remove(outputFilePath);
+
     std::ofstream outputFile(outputFilePath);
 
     if (!outputFile)
@@ -91,3 +93,59 @@ std::ofstream createOutputFile(const std::filesystem::path& outputFilePath) {
 
     return outputFile;
 }
+
+uint64_t getFnv1aHash(const std::string_view data) {
+    uint64_t hash = 0xcbf29ce484222325;
+
+    for (const char character : data) {
+        hash ^= static_cast<unsigned char>(character);
+        hash *= 0x100000001b3;
+    }
+
+    return hash;
+}
+
+std::string escapeJsonString(const std::string_view string) {
+    std::string escapedString;
+
+    for (const char character : string) {
+        if (character == '"' || character == '\\') {
+            escapedString += '\\';
+            escapedString += character;
+        } else if (static_cast<unsigned char>(character) < 0x20) {
+            escapedString += std::format("\\u{:04x}", static_cast<int>(character));
+        } else {
+            escapedString += character;
+        }
+    }
+
+    return escapedString;
+}
+
+std::string unescapeJsonString(const std::string_view string) {
+    std::string unescapedString;
+
+    for (size_t i = 0; i < string.length(); i++) {
+        if (string[i] != '\\' || i + 1 == string.length()) {
+            unescapedString += string[i];
+        } else if (string[++i] == 'u' && i + 4 < string.length()) {
+            unescapedString += static_cast<char>(
+                std::stoi(std::string(string.substr(i + 1, 4)), nullptr, 16));
+            i += 4;
+        } else {
+            unescapedString += string[i];
+        }
+    }
+
+    return unescapedString;
+}
+
+std::string getJsonNumber(const double number) {
+    if (!std::isfinite(number)) return "null";
+
+    std::ostringstream numberStream;
+
+    numberStream << number;
+
+    return numberStream.str();
+}
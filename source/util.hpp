@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <vector>
 #include <filesystem>
@@ -10,7 +12,15 @@ std::ifstream loadTextFile(const std::filesystem::path& filePath);
 time_t getCurrentTimeSeconds();
 std::vector<std::string> splitStringByDelimiter(const std::string& string,
                                                 const char delimiter);
+// Regular files in dirPath, sorted by path so that their order is the same on every run
 std::vector<std::filesystem::directory_entry>
 getFileEntries(const std::filesystem::path& dirPath);
-void printProgress(const size_t progress, const size_t total);
 std::ofstream createOutputFile(const std::filesystem::path& outputFilePath);
+// 64-bit FNV-1a hash, which (unlike std::hash) is the same on every platform
+uint64_t getFnv1aHash(const std::string_view data);
+// The string with quotes, backslashes and control characters escaped for JSON
+std::string escapeJsonString(const std::string_view string);
+// Reverses escapeJsonString
+std::string unescapeJsonString(const std::string_view string);
+// The number as JSON, which has no infinity or NaN, so these are written as null
+std::string getJsonNumber(const double number);
@@ -1,58 +1,67 @@
-#include "Vector2D.hpp"
+#include "vector2d.hpp"
 
 #include <string>
 #include <math.h>
 
-Vector2D::Vector2D(const double x, const double y)
+template <typename T>
+Vector2D<T>::Vector2D(const T x, const T y)
     : x(x)
     , y(y) {
 }
 
-Vector2D::Vector2D(const double n)
+template <typename T>
+Vector2D<T>::Vector2D(const T n)
     : Vector2D(n, n) {
 }
 
-Vector2D::Vector2D()
+template <typename T>
+Vector2D<T>::Vector2D()
     : Vector2D(0.0) {
 }
 
-Vector2D Vector2D::add(const Vector2D& v) const {
+template <typename T>
+template <typename U>
+Vector2D<T>::Vector2D(const Vector2D<U>& v)
+    : Vector2D(static_cast<T>(v.x), static_cast<T>(v.y)) {
+}
+
+template <typename T> Vector2D<T> Vector2D<T>::add(const Vector2D& v) const {
     return Vector2D(x + v.x, y + v.y);
 }
 
-Vector2D Vector2D::scalarProduct(const double n) const {
+template <typename T> Vector2D<T> Vector2D<T>::scalarProduct(const T n) const {
     return Vector2D(x * n, y * n);
 }
 
-double Vector2D::abs() const {
+template <typename T> T Vector2D<T>::abs() const {
     return sqrt(dotProduct(*this));
 }
 
-double Vector2D::dotProduct(const Vector2D& v) const {
+template <typename T> T Vector2D<T>::dotProduct(const Vector2D& v) const {
     return x * v.x + y * v.y;
 }
 
-Vector2D Vector2D::operator+(const Vector2D& v) const {
+template <typename T> Vector2D<T> Vector2D<T>::operator+(const Vector2D& v) const {
     return add(v);
 }
 
-Vector2D Vector2D::operator-(const Vector2D& v) const {
-    return add(v * (-1.0));
+template <typename T> Vector2D<T> Vector2D<T>::operator-(const Vector2D& v) const {
+    return add(v * static_cast<T>(-1.0));
 }
 
-double Vector2D::operator*(const Vector2D& v) const {
+template <typename T> T Vector2D<T>::operator*(const Vector2D& v) const {
     return dotProduct(v);
 }
 
-Vector2D Vector2D::operator*(const double n) const {
+template <typename T> Vector2D<T> Vector2D<T>::operator*(const T n) const {
     return scalarProduct(n);
 }
 
-Vector2D Vector2D::operator/(const double n) const {
-    return scalarProduct(1.0 / n);
+template <typename T> Vector2D<T> Vector2D<T>::operator/(const T n) const {
+    return scalarProduct(static_cast<T>(1.0) / n);
 }
 
-double Vector2D::operator[](const int i) const {
+template <typename T> T Vector2D<T>::operator[](const int i) const {
     if (i == 0)
         return x;
     else if (i == 1)
@@ -61,12 +70,23 @@ double Vector2D::operator[](const int i) const {
         throw std::invalid_argument("Index " + std::to_string(i) + " out of range");
 }
 
-Vector2D operator*(const double n, const Vector2D& v) {
+template <typename T>
+Vector2D<T> operator*(const std::type_identity_t<T> n, const Vector2D<T>& v) {
     return v.scalarProduct(n);
 }
 
-std::ostream& operator<<(std::ostream& stream, const Vector2D& v) {
+template <typename T>
+std::ostream& operator<<(std::ostream& stream, const Vector2D<T>& v) {
     stream << v.x << ", " << v.y;
 
     return stream;
 }
+
+template class Vector2D<double>;
+template class Vector2D<float>;
+template Vector2D<double>::Vector2D(const Vector2D<float>& v);
+template Vector2D<float>::Vector2D(const Vector2D<double>& v);
+template Vector2D<double> operator*(const double n, const Vector2D<double>& v);
+template Vector2D<float> operator*(const float n, const Vector2D<float>& v);
+template std::ostream& operator<<(std::ostream& stream, const Vector2D<double>& v);
+template std::ostream& operator<<(std::ostream& stream, const Vector2D<float>& v);
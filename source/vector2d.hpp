@@ -1,27 +1,31 @@
 #pragma once
 
 #include <iostream>
+#include <type_traits>
 
-class Vector2D {
+template <typename T> class Vector2D {
     public:
-        double x, y;
+        T x, y;
 
-        Vector2D(const double x, const double y);
-        Vector2D(const double n);
+        Vector2D(const T x, const T y);
+        Vector2D(const T n);
         Vector2D();
+        template <typename U> explicit Vector2D(const Vector2D<U>& v);
 
         Vector2D add(const Vector2D& v) const;
-        Vector2D scalarProduct(const double n) const;
-        double abs() const;
-        double dotProduct(const Vector2D& v) const;
+        Vector2D scalarProduct(const T n) const;
+        T abs() const;
+        T dotProduct(const Vector2D& v) const;
 
         Vector2D operator+(const Vector2D& v) const;
         Vector2D operator-(const Vector2D& v) const;
-        double operator*(const Vector2D& v) const;
-        Vector2D operator*(const double n) const;
-        Vector2D operator/(const double n) const;
-        double operator[](const int i) const;
+        T operator*(const Vector2D& v) const;
+        Vector2D operator*(const T n) const;
+        Vector2D operator/(const T n) const;
+        T operator[](const int i) const;
 };
 
-Vector2D operator*(const double n, const Vector2D& v);
-std::ostream& operator<<(std::ostream& stream, const Vector2D& v);
+template <typename T>
+Vector2D<T> operator*(const std::type_identity_t<T> n, const Vector2D<T>& v);
+template <typename T>
+std::ostream& operator<<(std::ostream& stream, const Vector2D<T>& v);